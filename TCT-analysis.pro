@@ -13,7 +13,8 @@ win32:LIBS += -LC:\root\root_v5.34.34\lib -llibCore -llibMathCore -llibTree -lli
 win32:INCLUDEPATH += C:\root\root_v5.34.34\include\
 
 # For Linux
-unix:QMAKE_CXXFLAGS += -std=c++11
+unix:QMAKE_CXXFLAGS += -std=c++11 -pthread
+unix:LIBS += -pthread
 unix:LIBS += -L/home/sasha/Root/root/lib/ -lCore -lMathCore -lTree -lCint -lRIO -lNet -lThread -lHist -lMatrix
 unix:INCLUDEPATH += /home/sasha/Root/root/include\
 
@@ -42,6 +43,11 @@ HEADERS += \
     include/tct_config.h \
     include/TCTModule.h \
     include/TCTReader.h \
+    include/TCTSwap.h \
+    include/TCTCatalog.h \
+    include/TCTFitter.h \
+    include/TCTDrift.h \
+    include/TCTField.h \
     include/util.h \
     include/modules/ModuleTopFindSensor.h \
     include/modules/ModuleDoubleChannelAnalysis.h
@@ -66,6 +72,11 @@ SOURCES += \
     src/tct_config.cc \
     src/TCTModule.cc \
     src/TCTReader.cc \
+    src/TCTSwap.cc \
+    src/TCTCatalog.cc \
+    src/TCTFitter.cc \
+    src/TCTDrift.cc \
+    src/TCTField.cc \
     src/util.cc \
     src/modules/ModuleTopFindSensor.cc \
     src/modules/ModuleDoubleChannelAnalysis.cc
@@ -0,0 +1,75 @@
+/**
+ * \file
+ * \brief Definition of the TCTCatalog class.
+ * \details Index of the headers of the .tct files in a data folder, kept in one text file.
+ *
+ */
+
+#include <string>
+#include <vector>
+
+#ifndef ROOT_TCTCatalog
+#define ROOT_TCTCatalog
+//////////////////////////////////////////////////////////////////////////
+//                                                                      //
+// Catalog of the TCT scans of a folder                                 //
+//                                                                      //
+// The headers of the .tct files (read with TCTReader in Mode=5) are    //
+// stored together with the size, modification time and hash of the     //
+// file in <folder>/tct_catalog.txt, one file per line:                 //
+// name <tab> hash size mtime type date[6] abstime T Source             //
+//      x0 dx Nx y0 dy Ny z0 dz Nz t0 dt NP WFOnOff[4]                  //
+//      NU1 U1[NU1] NU2 U2[NU2] <tab> User <tab> Sample <tab> Comment   //
+// Update() reads only the files which are new or changed since the     //
+// last update, Select() answers queries without opening any .tct file. //
+//                                                                      //
+//////////////////////////////////////////////////////////////////////////
+
+#include <Rtypes.h>
+
+struct TCTCatalogEntry
+{
+    std::string Name;             // name of the file in the folder
+    ULong64_t Hash;               // hash of the content of the file
+    Long64_t Size;                // size of the file in bytes
+    Long64_t MTime;               // time of the last modification of the file
+    Int_t type;
+    Int_t Date[6];
+    Int_t abstime;
+    Float_t T;                    // temperature
+    Float_t Source;               // type of e-h generation
+    Float_t x0,dx,y0,dy,z0,dz;
+    Int_t Nx,Ny,Nz;
+    Float_t t0,dt;
+    Int_t NP;
+    Int_t WFOnOff[4];
+    std::vector<Float_t> U1,U2;   // voltages
+    std::string User;
+    std::string Sample;
+    std::string Comment;
+};
+
+class TCTCatalog
+{
+    private:
+        std::string Folder;                   // folder with the .tct files, ending with /
+        std::string IndexFile;                // catalog file
+        std::vector<TCTCatalogEntry> Entries;
+        Bool_t Fill(TCTCatalogEntry &, const Char_t *);
+        Bool_t Match(TCTCatalogEntry &, std::string &);
+    public:
+        TCTCatalog(const Char_t *, const Char_t * =NULL);
+        Bool_t Load();
+        Bool_t Save();
+        Int_t Update();
+        Int_t GetEntries() {return Entries.size();}
+        TCTCatalogEntry &GetEntry(Int_t i) {return Entries[i];}
+        Int_t Find(const Char_t *);
+        std::vector<Int_t> Select(const Char_t *);
+        void Print(Int_t);
+        std::string StringInfo(Int_t);
+        static ULong64_t Hash(const Char_t *);
+        static Bool_t Stat(const Char_t *, Long64_t &, Long64_t &);
+};
+
+#endif // ROOT_TCTCatalog
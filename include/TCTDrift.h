@@ -0,0 +1,78 @@
+/**
+ * \file
+ * \brief Definition of the TCT::DriftModel class.
+ * \details Drift velocity and mobility of electrons and holes in silicon as functions of the electric field.
+ */
+
+#ifndef __TCTDRIFT_H__
+#define __TCTDRIFT_H__ 1
+
+#include <vector>
+
+namespace TCT {
+
+  class tct_config;
+
+  /// Drift velocity of the charge carriers, tabulated for the fast evaluation in the analysis loops
+  class DriftModel {
+    /** All models have the form \f$v = \mu_0 E/(1+(\mu_0 E/v_{sat})^\beta)^{1/\beta}\f$ and differ in the
+     *  parameters:
+     *  - kConfig: \f$\mu_0\f$ and \f$v_{sat}\f$ from the configuration file, \f$\beta\f$=2 for electrons, 1 for holes
+     *  - kCanali: \f$\mu_0\f$ from the configuration file, \f$v_{sat}\f$ and \f$\beta\f$ of Canali et al. at the temperature
+     *  - kJacoboni: all parameters of Jacoboni et al. at the temperature
+     *
+     *  The velocity, the mobility and the inverse of the sum of the velocities of electrons and holes
+     *  are tabulated with their derivatives and interpolated with cubic Hermite polynomials, so the
+     *  cost of the evaluation does not depend on the model.
+     *  Units: E - V/cm, v - cm/s, \f$\mu\f$ - cm2/(V*s).
+     */
+
+    public :
+        enum Carrier { kElectron=0, kHole=1 };
+        enum Model { kConfig=0, kCanali=1, kJacoboni=2 };
+
+        /// Model selected with the DriftModel and Temperature cards of the configuration
+        DriftModel(tct_config *config, int n=16384, double Emax=1e6);
+        DriftModel(int model, double mu0_els, double mu0_holes, double v_sat, double T=300, int n=16384, double Emax=1e6);
+
+        // exact model
+        double Mu0(int type) const { return fMu0[type]; }
+        double Vsat(int type) const { return fVsat[type]; }
+        double Beta(int type) const { return fBeta[type]; }
+        double ExactVelocity(double E, int type, double *slope=0) const;
+        double ExactMobility(double E, int type, double *slope=0) const;
+
+        // tables
+        double Velocity(double E, int type) const { return Interpolate(fVel[type],E); }
+        double Mobility(double E, int type) const { return Interpolate(fMob[type],E); }
+        /// Sum of the velocities of electrons and holes
+        double VelocitySum(double E, double *slope=0) const;
+        /// Field at which the sum of the velocities is u, within +-Emax
+        double Field(double u) const;
+
+        // batch evaluation
+        void Velocity(int n, const double *E, int type, double *v) const;
+        void Mobility(int n, const double *E, int type, double *mu) const;
+        /// E[i] = Field(scale*u[i])
+        void Field(int n, const double *u, double scale, double *E) const;
+
+        double GetEmax() const { return fEmax; }
+        static const char* ModelName(int model);
+        /// Form of the models as ROOT formula of x=E: [0] - mu0, [1] - vsat, [2] - beta
+        static const char* Formula() { return "[0]*x/pow(1.0+pow([0]*abs(x)/[1],[2]),1.0/[2])"; }
+
+    private :
+        /// Equidistant table of a function on [0,fEmax] (or of the inverse on [0,fUmax]): values and derivatives
+        struct Table { std::vector<double> y, dy; double step; bool odd; };
+
+        int fModel;
+        double fMu0[2], fVsat[2], fBeta[2];
+        double fEmax, fUmax;
+        Table fVel[2], fMob[2], fInv;
+
+        void Init(int model, double mu0_els, double mu0_holes, double v_sat, double T, int n, double Emax);
+        double Interpolate(const Table &t, double x, double *slope=0) const;
+
+    }; // end of class DriftModel
+}
+#endif
@@ -0,0 +1,21 @@
+/**
+ * \file
+ * \brief Electric field profiles of the edge-TCT from the charge profiles (see ModuleEdgeField).
+ * \details Kept free of ROOT, so the solver can be checked and timed on its own.
+ */
+
+#ifndef __TCTFIELD_H__
+#define __TCTFIELD_H__ 1
+
+#include "TCTDrift.h"
+
+namespace TCT {
+
+  /// Field profile for the normalisation constant a, returns its integral between ix1 and ix2 (the voltage)
+  double FieldProfile(const DriftModel &drift, int n, const double *charge, int ix1, int ix2, double Ss, double a, double *field);
+
+  /// Normalisation constant a for which the field integrates to the voltage U, false if U is not reached within eps
+  bool Normalisation(const DriftModel &drift, double U, int n, const double *charge, int ix1, int ix2, double Ss, double &a, double eps, double *field);
+
+}
+#endif
@@ -0,0 +1,87 @@
+/**
+ * \file
+ * \brief Definition of the TCT::FitModel and TCT::Fitter classes.
+ * \details Least-squares fitter for the fixed models of the charge profiles (edges of the sensor, strip).
+ */
+
+#ifndef __TCTFITTER_H__
+#define __TCTFITTER_H__ 1
+
+namespace TCT {
+
+  /// Model function with analytic derivatives, fitted by TCT::Fitter
+  class FitModel {
+
+    public :
+        virtual ~FitModel() {}
+        /// Number of parameters (at most Fitter::MaxPar)
+        virtual int NPar() const = 0;
+        /// Value at x, the derivatives with respect to the parameters are written to grad if it is not NULL
+        virtual double Eval(double x, const double *par, double *grad) const = 0;
+        /// Same function as ROOT formula, for storing the result in a TF1
+        virtual const char* Formula() const = 0;
+
+    }; // end of class FitModel
+
+  /// Left edge of the sensor: -[2]*TMath::Erfc((x-[0])/[1])+[3]
+  class ErfcEdgeModel : public FitModel {
+    public :
+        int NPar() const { return 4; }
+        double Eval(double x, const double *par, double *grad) const;
+        const char* Formula() const { return "-[2]*TMath::Erfc((x-[0])/[1])+[3]"; }
+    };
+
+  /// Right edge of the sensor: -[2]*TMath::Erf((x-[0])/[1])+[3]
+  class ErfEdgeModel : public FitModel {
+    public :
+        int NPar() const { return 4; }
+        double Eval(double x, const double *par, double *grad) const;
+        const char* Formula() const { return "-[2]*TMath::Erf((x-[0])/[1])+[3]"; }
+    };
+
+  /// Profile across a strip: [2]/2.*(TMath::Erfc((x-[0])/[1]) + (TMath::Erf((x-[0]-[3])/[1]) + 1))
+  class StripModel : public FitModel {
+    public :
+        int NPar() const { return 4; }
+        double Eval(double x, const double *par, double *grad) const;
+        const char* Formula() const { return "[2]/2.*(TMath::Erfc((x-[0])/[1]) + (TMath::Erf((x-[0]-[3])/[1]) + 1))"; }
+    };
+
+  /// Levenberg-Marquardt least-squares fit of a FitModel to points with equal weights
+  class Fitter {
+
+    public :
+        static const int MaxPar = 8;
+
+        Fitter(const FitModel &model);
+
+        void SetMaxIterations(int val) { fMaxIter = val; }
+        void SetTolerance(double val) { fTolerance = val; }
+
+        /// Fits the points with xmin <= x <= xmax, par holds the start values and gets the result
+        bool Fit(int n, const double *x, const double *y, double xmin, double xmax, double *par);
+
+        // results of the last fit
+        const double* GetErrors() const { return fErr; }
+        double GetChisquare() const { return fChi2; }
+        int GetNDF() const { return fNDF; }
+        int GetNumberFitPoints() const { return fNPoints; }
+        int GetIterations() const { return fIter; }
+
+    private :
+        const FitModel &fModel;
+        int fMaxIter;
+        double fTolerance;
+        double fErr[MaxPar];
+        double fChi2;
+        int fNDF;
+        int fNPoints;
+        int fIter;
+
+        double Normal(int n, const double *x, const double *y, const double *par, double *A, double *b) const;
+        static bool Solve(int np, const double *A, const double *b, double lambda, double *dp);
+        static bool Invert(int np, const double *A, double *inv);
+
+    }; // end of class Fitter
+}
+#endif
@@ -10,6 +10,7 @@
 #include <iostream>
 #include "fstream"
 #include <vector>
+#include <functional>
 
 // ROOT includes
 #include "TFile.h"
@@ -18,6 +19,7 @@
 // TCT includes
 #include "tct_config.h"
 #include "TCTReader.h"
+#include "TCTFitter.h"
 
 #ifdef USE_GUI
 #include "QVBoxLayout"
@@ -25,6 +27,27 @@
 
 namespace TCT {
 
+/// Fit results of the two edges of one charge profile (see TCTModule::FindEdges)
+struct EdgeFit {
+    Double_t par[2][4];           // parameters of the left and the right edge
+    Double_t err[2][4];           // their errors
+    Double_t chi2[2];
+    Int_t ndf[2];
+    Int_t npoints[2];
+    Double_t xmin[2],xmax[2];     // fit ranges
+    Bool_t ok[2];                 // fit converged
+};
+
+/// Statistics of a series of fits with warm start (see TCTModule::FitStep)
+struct FitCount {
+    Int_t cold;                   // fits from the heuristic start values
+    Int_t warm;                   // fits started from the solution of the previous step
+    Int_t fallback;               // warm starts which failed and were repeated from the heuristic values
+    Long64_t cold_calls;          // iterations (FastFit) or function calls (Minuit) of the cold fits
+    Long64_t warm_calls;          // the same for the warm starts
+    FitCount() : cold(0), warm(0), fallback(0), cold_calls(0), warm_calls(0) {}
+};
+
 enum TCT_Type {
     _Top = 0,
     _Edge,
@@ -74,9 +97,17 @@ enum TCT_Type {
         // default functions
         void SwitchAxis(Int_t sw, Int_t& nPoints, Float_t& step, Float_t& p0);
         void CalculateCharges(Int_t Channel, Int_t Ax, Int_t numAx,  Int_t scanning, Int_t numS, TGraph **charges, Float_t tstart, Float_t tfinish);
+        TGraph* ChargeProfile(const TCTView &view, Float_t tstart, Float_t tfinish);
         TGraph** NormedCharge(TGraph** sensor, TGraph** photodiode, Int_t numP);
         void FindEdges(TGraph* gr, Int_t numS, Float_t dx, Double_t &left_edge, Double_t &right_edge);
         void FindEdges(TGraph** gr, Int_t numP, Int_t numS, Float_t dx, Float_t* left_pos, Float_t* left_width, Float_t* right_pos, Float_t* right_width);
+        void EdgeStart(const Double_t* y, Int_t numS, Float_t dx, Float_t FWHM, Double_t* left, Double_t* right, Double_t& middle);
+        void FitEdges(TGraph* gr, Int_t numS, Float_t dx, TF1* ff_left, TF1* ff_right, EdgeFit& fit, const EdgeFit* prev = NULL, FitCount* count = NULL);
+        Bool_t FitGraph(TGraph* gr, TF1* ff, const FitModel& model, Bool_t store, Bool_t plus = false, Int_t* iterations = NULL);
+        Bool_t FitOnce(TGraph* gr, TF1* ff, const FitModel& model, Int_t& calls);
+        Bool_t FitStep(TGraph* gr, TF1* ff, const FitModel& model, const Double_t* start, FitCount* count);
+        void PrintFitCount(const FitCount& count, const char* title);
+        void StoreFunction(TGraph* gr, TF1* ff, Bool_t plus);
         TGraph* GraphBuilder(Int_t N, Float_t *x, Float_t *y, const char *namex, const char *namey, const char *title);
         void GraphBuilder(Int_t N, Float_t *x, Float_t *y, const char *namex, const char *namey, const char *title, const char *write_name);
         TGraph* GraphBuilder(Int_t N, Double_t *x, Double_t *y, const char *namex, const char *namey, const char *title);
@@ -86,6 +117,8 @@ enum TCT_Type {
         void MultiGraphWriter(Int_t N, TGraph **gr, const char *namex, const char *namey, const char *title, const char *write_name);
         void SetFitParameters(TF1* ff, Double_t p0, Double_t p1, Double_t p2, Double_t p3);
         Double_t GraphIntegral(TGraph *gr, Double_t x1, Double_t x2);
+        void ParallelFor(Int_t n, const std::function<void(Int_t)> &task, Long64_t work = 0);
+        ULong64_t ProductKey(const char* what, TGraph* gr, Int_t n, Double_t p1 = 0, Double_t p2 = 0);
         Double_t abs(Double_t x);
         void ChargeCorrelationHist(TGraph** sensor, TGraph** photodetector, Int_t numO);
 
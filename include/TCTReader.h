@@ -8,6 +8,8 @@
 
 #include <stdio.h>
 #include <iostream>
+#include <vector>
+#include <map>
 
 #ifndef ROOT_TCTReader
 #define ROOT_TCTReader
@@ -41,12 +43,62 @@
 #include <TObject.h>
 class TCTWaveform;
 
+class TCTView;
+
 class TCTReader
 {
     private:
         void  swoo(char *, char *);
         void  swooip(float *, int);
         int BLE_CODE;
+        Int_t Mode;                   // storage of the waveforms (see constructor)
+        Float_t Time0;                // time shift, kept for the histograms built on request
+        Long64_t DataStart;           // position of the first waveform record in the binary file
+        Char_t *Map;                  // memory mapped input file (Mode=1)
+        Long64_t MapSize;             // size of the mapped file
+        Long64_t *Offset[4];          // position of every waveform in the mapped file
+        Float_t *Store[4];            // contiguous [waveform][NP] samples (Mode=2, or decoded from the map)
+        Char_t *Ready[4];             // waveform already decoded into Store
+        Int_t CacheSize;              // number of waveforms kept in memory (Mode=3)
+        TClonesArray *Cache;          // histograms of the waveforms read on request (Mode=3)
+        Int_t *Slot[4];               // cache slot of every waveform, -1 if it is not in memory
+        Int_t *SlotCh,*SlotWF;        // channel and waveform held by the cache slot
+        Int_t *SlotPrev,*SlotNext;    // cache slots ordered from the most to the least recently used
+        Int_t CacheFirst,CacheLast,CacheUsed;
+        Int_t LazyBaseLine;           // channels (bit mask) with baseline correction applied on reading (Mode=3,4)
+        Float_t LazyXc;               // start of the pulse for the baseline correction
+        Int_t LazyFlip[4];            // polarity correction applied on reading (Mode=3,4)
+        Int_t LazyVote;               // channels (bit mask) whose polarity is decided on the first reading (Mode=3)
+        Float_t *SliceBuf;            // samples of the voltage slice in memory (Mode=4)
+        Long64_t SliceBytes;          // size of one voltage slice in the file
+        Int_t CurSlice;               // voltage slice in SliceBuf, -1 if none
+        Double_t *Cum[4];             // prefix sums [waveform][NP+1] of the samples, NULL if not built
+        Int_t CumMask;                // channels (bit mask) which get the prefix sums
+        struct ChargeMapEntry {Int_t ch; Float_t mint,maxt; Float_t *map;};
+        std::vector<ChargeMapEntry> Maps;                    // charge maps made by ChargeMap
+        std::map<ULong64_t, std::vector<Double_t> > Products; // results stored by the modules (see SetProduct)
+        std::ostream *Out;            // stream of the progress messages
+        TClonesArray *Histos(Int_t);
+        void MakeHistos();
+        Bool_t HasChannel(Int_t ch) {return ch>=0 && ch<4 && WFOnOff[ch];}
+        Float_t *Samples(Int_t, Int_t);
+        TH1F *NewHisto(Int_t, Int_t);
+        void AllocStore();
+        void AllocCache();
+        void ResetCache();
+        Int_t Decode(Int_t, Int_t);
+        void LazyCorrect(Int_t, Float_t *);
+        Int_t PolarityVote(Int_t);
+        Float_t *SliceWF(Int_t, Int_t);
+        Bool_t ReadAt(Long64_t, void *, Long64_t);
+        Double_t BaseLine(Float_t *, Int_t, Double_t &);
+        Int_t BaseMethod;             // estimator of the baseline (see SetBaseLine)
+        Float_t BaseTrim;             // fraction of the samples cut on each side by the trimmed mean
+        Float_t BaseTail;             // start of the tail window of the linear baseline
+        Long64_t ParseWFs(std::vector<Float_t> &);
+        Bool_t MapFile();
+        Bool_t IndexWFsBin();
+        void ReadHeaderBin();
     public:
 
         FILE *in;
@@ -77,7 +129,7 @@ class TCTReader
         Char_t *Comment;              // Comment
         Char_t *FileName;             // The name of the input file
 
-        TCTReader(Char_t *, Float_t=0,Int_t=0);
+        TCTReader(Char_t *, Float_t=0,Int_t=0,Int_t=0,Int_t=4096,std::ostream * =&std::cout);
         ~TCTReader();
         void  ReadWFs(Float_t=0);
         void  ReadWFsBin(Float_t=0);
@@ -86,6 +138,9 @@ class TCTReader
         Float_t GetWidth(TH1F *, Int_t &, Int_t &,  Float_t=0, Float_t=25, Float_t=-1111, Float_t=-1111, Int_t = 50);
         TH1F *GetHA(Int_t , Int_t);
         TH1F *GetHA(Int_t , Int_t, Int_t, Int_t, Int_t=0, Int_t=0);
+        Float_t *GetWF(Int_t , Int_t);
+        Int_t GetMode() {return Mode;}
+        Int_t TimeBin(Float_t);
 //        TGraph *GetIV() {TGraph *gr=new TGraph(U1.GetSize(),U1.GetArray(),I1.GetArray()); return gr;}
 
         TH2F *Draw(Int_t=0, Int_t=0, Int_t=0, Int_t=0, Int_t=0, Int_t=0, Float_t=0, Float_t=25);
@@ -95,14 +150,70 @@ class TCTReader
         void PrintInfo();
         std::string StringInfo();
         void CorrectBaseLine(Float_t=0.0);
+        void SetBaseLine(Int_t, Float_t=0.1, Float_t=-1111);
         void CorrectPolarity(Int_t=0);
+        void Preprocess(Float_t, Int_t, Int_t, Int_t=0);
+        Bool_t WriteBin(const Char_t *);
+        void SetIntegrals(Int_t);
+        void BuildIntegrals();
+        Bool_t HasIntegrals(Int_t ch) {return ch>=0 && ch<4 && Cum[ch]!=NULL;}
+        Double_t Integral(Int_t, Int_t, Float_t=-1111, Float_t=-1111);
+        void Integrals(Int_t, Float_t, Float_t, Float_t *, Int_t=0);
+        const Float_t *ChargeMap(Int_t, Float_t, Float_t, Int_t=0);
+        Bool_t GetProduct(ULong64_t, std::vector<Double_t> &);
+        void SetProduct(ULong64_t, const std::vector<Double_t> &);
+        void ClearProducts();
 
         TCTWaveform *Projection(int ch, int dir,int x,int y,int z, int nu1, int nu2, int num);
         TCTWaveform *Projection(int , int *);
+        TCTView View(Int_t ch, Int_t dir, Int_t x, Int_t y, Int_t z, Int_t nu1, Int_t nu2, Int_t num);
 
         //ClassDef(TCTReader,1);
 };
 
+class TCTView
+{
+    // Projection of the waveforms of one channel along one axis, without copying them (see TCTReader::View)
+    // Only the first index, the stride and the coordinates are kept; the view is valid while the reader exists.
+    private:
+        TCTReader *Reader;
+        Int_t Ch;                     // channel
+        Int_t Dir;                    // direction of the projection, 0-2 - x,y,z, 3,4 - U1,U2
+        Int_t First;                  // index (see TCTReader::indx) of the first waveform
+        Int_t Stride;                 // distance between the indices of two neighbouring waveforms
+        Int_t Start;                  // position of the first waveform along the axis
+        Int_t N;                      // number of waveforms
+    public:
+        TCTView() : Reader(NULL), Ch(0), Dir(0), First(0), Stride(1), Start(0), N(0) {}
+        TCTView(TCTReader *r, Int_t ch, Int_t dir, Int_t first, Int_t stride, Int_t start, Int_t n) :
+            Reader(r), Ch(ch), Dir(dir), First(first), Stride(stride), Start(start), N(n) {}
+        TCTReader *GetReader() const {return Reader;}
+        Int_t GetChannel() const {return Ch;}
+        Int_t GetN() const {return N;}
+        Int_t Index(Int_t i) const {return First+i*Stride;}
+        Float_t *WF(Int_t i) const {return Reader->GetWF(Ch,Index(i));}
+        TH1F *GetHA(Int_t i) const {return Reader->GetHA(Ch,Index(i));}
+        Double_t Integral(Int_t i, Float_t mint=-1111, Float_t maxt=-1111) const {return Reader->Integral(Ch,Index(i),mint,maxt);}
+        Float_t Coordinate(Int_t i) const
+        {
+            // position (um) or voltage (V) of the i-th waveform, the same as Delta in TCTReader::Projection
+            switch(Dir)
+            {
+            case 1: return i*Reader->dy;
+            case 2: return i*Reader->dz;
+            case 3: return Start+i<Reader->NU1 ? Reader->U1[Start+i] : 0;
+            case 4: return Start+i<Reader->NU2 ? Reader->U2[Start+i] : 0;
+            default: return i*Reader->dx;
+            }
+        }
+        Float_t Abscissa(Int_t i) const
+        {
+            // x of the i-th point of the charge graph, the index if there is no position or voltage (as TCTWaveform::GetIntegral)
+            Float_t c=Coordinate(i);
+            return (c!=0 || Coordinate(i+1)!=0) ? c : (Float_t)i;
+        }
+};
+
 #endif // ROOT_TCTReader
 
 /////////////////////////////////////////////////////
@@ -131,6 +242,9 @@ class TCTWaveform {
         TArrayF 	 Date;		//Date of the Measurement (or simulation)
         TArrayF        Frequencies;   //Array of Frequnecies
         Float_t        AnnealTime;
+        TCTReader      *Reader;       //! reader the waveforms were projected from
+        Int_t          Channel;       //! channel of the waveforms in the reader
+        Int_t          *Index;        //! indices of the waveforms in the reader
 
     public:
         TPaveText *pt;                //!
@@ -145,12 +259,13 @@ class TCTWaveform {
 
         void AddHisto(Int_t,Float_t,TH1F *); //voltage index, voltage, histogram
         void AddHisto(Float_t,TH1F *); //voltage, histogram
+        void SetSource(TCTReader *,Int_t,Int_t *); //reader, channel, indices of the waveforms
         //Voltage Current Section
         inline void SetAnnealTime(Float_t x) {AnnealTime=x;}
         inline Float_t GetAnnealTime() {return AnnealTime;}
         void SetVoltages(Float_t *voltages) {Voltages.Adopt(Multiple,voltages);};
         void SetVoltage(Int_t index, Float_t voltage) {Voltages[index]=voltage;};
-        Int_t int2ascii(Char_t v[],Float_t,Int_t=1);
+        static Int_t int2ascii(Char_t v[],Float_t,Int_t=1);
         void SetHistoTime(int ind,Float_t start);
         void SetHistoTime(int num,Float_t *start);
         Float_t GetVoltage(Int_t index) {return(Voltages[index]);}
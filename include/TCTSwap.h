@@ -0,0 +1,19 @@
+/**
+ * \file
+ * \brief Byte swapping of the big endian binary files.
+ * \details Used by TCTReader, kept free of ROOT so the kernels can be checked and timed on their own.
+ */
+
+#ifndef __TCTSWAP_H__
+#define __TCTSWAP_H__ 1
+
+namespace TCT {
+
+  /// Reverses the byte order of n floats in place, blocks with the widest vector instructions the code was built for
+  void SwapBytes(float *in, int n);
+
+  /// Same as SwapBytes, one byte pair at the time (the original loop of TCTReader), reference for the checks
+  void SwapBytesScalar(float *in, int n);
+
+}
+#endif
@@ -297,6 +297,13 @@ namespace TCT {
         delete _H_acquisition;
         delete _H_acquisitionFILTERED;
       }
+      /// Frees all but the pulse histogram, which is kept for the output of the single acquisitions
+      void Strip(){
+        delete _H_acquisitionFILTERED;
+        _H_acquisitionFILTERED = 0;
+        std::vector<double>().swap(volt);
+        std::vector<double>().swap(time);
+      }
 
       void Print();
       void GetOffsetNoise(uint32_t iAcq, TCT::acquisition_avg *avg);
@@ -310,6 +317,9 @@ namespace TCT {
       void PrintAcq();
       bool Read(FILE *infile, uint32_t iFile);
       bool ReadRAW(std::string fullfname, uint32_t iFile);
+      bool Parse(FILE *infile);
+      bool ParseRAW(std::string fullfname);
+      void MakeHistograms(uint32_t iFile);
       bool Read(FILE *infile, uint32_t iFile, TCT::acquisition_avg *avg); 
       void FillNtuple(TCT::acquisition_avg *avg);
       void SignalFinder(TCT::acquisition_avg *avg, float, float, float );
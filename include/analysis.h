@@ -26,6 +26,7 @@ namespace TCT {
     private :
 
       uint32_t _MaxAcqs;
+      uint32_t _StreamAcqs;
       float _Noise_Cut;		// in V
       float _NoiseEnd_Cut;
       float _S2n_Cut;
@@ -57,6 +58,7 @@ namespace TCT {
 
       analysis() :
     _MaxAcqs(-1),
+    _StreamAcqs(0),
 	_Noise_Cut(0.01),
 	_NoiseEnd_Cut(0.01),
      _S2n_Cut(9.),
@@ -91,6 +93,10 @@ namespace TCT {
       void SetMaxAcqs(uint32_t val) { _MaxAcqs = val;}
       const uint32_t & MaxAcqs() const { return _MaxAcqs;}
 
+      uint32_t StreamAcqs() { return _StreamAcqs;}
+      void SetStreamAcqs(uint32_t val) { _StreamAcqs = val;}
+      const uint32_t & StreamAcqs() const { return _StreamAcqs;}
+
       float S2n_Cut() { return _S2n_Cut;}
       void SetS2n_Cut (float val) { _S2n_Cut = val;}
       const float & S2n_Cut() const { return _S2n_Cut;}
@@ -171,6 +177,8 @@ namespace TCT {
       void AcqsSmearer(TCT::acquisition_single *acq, bool, float jitter);
       void AcqsAnalyser(TCT::acquisition_single *acq, uint32_t iAcq, TCT::acquisition_avg *acqAvg);
       void AcqsProfileFiller(TCT::acquisition_single *acq, TCT::acquisition_avg *acqAvg);
+      /// Smears, analyses, selects and profile-fills a block of acquisitions, then drops them
+      void AcqsProcessor(std::vector<TCT::acquisition_single> *acqs, uint32_t first, TCT::acquisition_avg *acqAvg, int *Nselected, std::vector<TCT::acquisition_single> *singles);
 
       void AcqsWriter(std::vector<TCT::acquisition_single> *acqs, TCT::acquisition_avg *acqAvg, bool HasSubs = true);
       //void AcqsWriterNoSubs(std::vector<TCT::acquisition_single> *acqs, TCT::acquisition_avg *acqAvg);
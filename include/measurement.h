@@ -26,6 +26,7 @@ namespace TCT {
     private :
       std::string _Name;
       std::string _DataInFolder; // Folder, where the associated data files are
+      std::vector<std::string> _Files; // Acquisition files of the folder, set by AcqsLister
 
       bool _IsManyPulseStructure; //
       bool _IsMIP; //
@@ -71,7 +72,12 @@ namespace TCT {
       bool IsMIP() { return _IsMIP;} 
       void SetIsMIP(bool Is) { _IsMIP = Is;} 
 
-      bool AcqsLoader(std::vector<TCT::acquisition_single> *acqs, uint32_t maxAcqs = -1, bool LeCroyRAW = false);
+      /// Reads the acquisitions of the data folder, the files are parsed on nthreads threads (0 - all cores)
+      bool AcqsLoader(std::vector<TCT::acquisition_single> *acqs, uint32_t maxAcqs = -1, bool LeCroyRAW = false, uint32_t nthreads = 0);
+      /// Lists the acquisition files of the data folder, returns their number
+      uint32_t AcqsLister(uint32_t maxAcqs = -1, bool LeCroyRAW = false);
+      /// Reads the listed acquisitions first..first+n-1, appending them to acqs
+      bool AcqsBlockLoader(std::vector<TCT::acquisition_single> *acqs, uint32_t first, uint32_t n, bool LeCroyRAW = false, uint32_t nthreads = 0);
 
   };
 }
@@ -32,10 +32,6 @@ namespace TCT {
         float GetEV_Time() { return _EV_Time; }
 
   private:
-        Double_t ff(Double_t E, Double_t Uuu, Double_t a);
-        Double_t BiSectionMethod(Double_t eps, Double_t x1, Double_t x2, Double_t Uuu, Double_t a);
-        Double_t Mu(Double_t E, Int_t Type);
-        template <typename T> int sgn(T val);
         float _EV_Time;
 
     };
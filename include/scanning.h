@@ -9,6 +9,9 @@
 // STD includes
 #include <iostream>
 #include <vector>
+#include <string>
+#include <sstream>
+#include <thread>
 
 // ROOT includes
 #include "TFile.h"
@@ -24,6 +27,26 @@ class TCTReader;
 
 namespace TCT {
 
+  /// Settings of the reading and of the corrections of a data file, copied from the configuration
+  /// so that the file can be opened on another thread (see Prefetch)
+  struct ReadSettings {
+      float time0;            ///< time shift of the waveforms
+      int mode;               ///< ReaderMode
+      int cache;              ///< ReaderCache
+      int base;               ///< channels (bit mask) with the baseline correction
+      int flip;               ///< channels with the polarity correction (detectors)
+      int need;               ///< channels which must have data (see Scanning::CheckData)
+      int cum;                ///< channels with the prefix sums (IntegralTables)
+      int method;             ///< BaselineMethod
+      float trim, tail;       ///< BaselineTrim, BaselineTail
+      float bias;             ///< CorrectBias
+      int threads;            ///< threads of TCTReader::Preprocess, 0 - one per core
+      std::string folder;     ///< CacheFolder, the cache is off if empty
+      std::string name;       ///< correction settings of the cache file name (see Scanning::CacheSettings)
+
+      ReadSettings(tct_config* config, float time0);
+  };
+
   class Scanning {
 
     private :
@@ -44,14 +67,41 @@ namespace TCT {
         // Destructor
         //~Scanning();
 #ifndef USE_GUI
-        bool ReadTCT(char* filename, tct_config* config1);
+        bool ReadTCT(char* filename, tct_config* config1, ULong64_t hash = 0, TCTReader* reader = 0);
 #else
-        bool ReadTCT(char* filename, tct_config* config1, Ui::ConsoleOutput *progress);
+        bool ReadTCT(char* filename, tct_config* config1, Ui::ConsoleOutput *progress, ULong64_t hash = 0, TCTReader* reader = 0);
 #endif
         bool CreateOutputFile();
+        static TCTReader* OpenTCT(char* filename, const ReadSettings &settings, ULong64_t hash, std::ostream &out);
+        static std::string CacheFile(const char* filename, const ReadSettings &settings, ULong64_t hash);
+        static ULong64_t FileHash(const char* filename, bool* hashed = 0);
+        static std::string CacheSettings(tct_config* config, float time0);
+        static std::string CacheName(ULong64_t hash, const std::string &settings);
         bool Separate_and_Sample();
         bool CheckData();
 
     }; // end of class scanning
+
+  /// Reads and corrects the next data file in the background while the current one is analysed
+  class Prefetch {
+
+    private :
+        std::thread worker;
+        std::string file;
+        std::vector<char> path;       ///< file name given to the reader
+        ReadSettings *settings;
+        ULong64_t hash;
+        TCTReader *reader;            ///< reader made in the background (ReaderMode 1,2), NULL otherwise
+        std::ostringstream log;       ///< messages of the reader, printed when it is handed over
+        void Run();
+
+    public :
+        Prefetch() : settings(0), hash(0), reader(0) {};
+        ~Prefetch();
+
+        void Start(std::string filename, tct_config* config);
+        ULong64_t Wait(std::string filename, TCTReader** next = 0);
+
+    }; // end of class prefetch
 }
 #endif 
@@ -26,6 +26,7 @@ private :
     std::string _OutFolder; // Folder, where the root file is writen to
     std::string _OutSample_ID;
     std::string _DataFolder; //
+    std::string _CacheFolder; // Folder for the corrected waveforms of the read files, no cache if empty
 
     std::vector<TCTModule*> tct_modules;
 
@@ -49,11 +50,22 @@ private :
     bool _FSeparateWaveforms;
     float _Movements_dt;
     float _CorrectBias;
+    uint32_t _BaselineMethod;
+    float _BaselineTrim;
+    float _BaselineTail;
+    bool _IntegralTables;
+    bool _FastFit;
+    bool _FitContinuation;
+    uint32_t _ReaderMode;
+    uint32_t _ReaderCache;
+    uint32_t _Threads;
 
     //coefficients
     float _mu0_els;
     float _mu0_holes;
     float _v_sat;
+    uint32_t _DriftModel;
+    float _Temperature;
     float _ampl;
     float _light_split;
     float _R_sensor;
@@ -66,6 +78,7 @@ public:
     tct_config() :
         _OutFolder("../results/"),
         _DataFolder("def"),
+        _CacheFolder(""),
         _CH1_Det(0),
         _CH2_Det(0),
         _CH_PhDiode(0),
@@ -73,8 +86,19 @@ public:
         _OptAxis(3),
         _Movements_dt(0),
         _CorrectBias(5.0),
+        _BaselineMethod(0),
+        _BaselineTrim(0.1),
+        _BaselineTail(-1111),
+        _IntegralTables(false),
+        _FastFit(false),
+        _FitContinuation(false),
+        _ReaderMode(0),
+        _ReaderCache(4096),
+        _Threads(1),
         _FFWHM(10.),
-        _TCT_Mode(0)
+        _TCT_Mode(0),
+        _DriftModel(0),
+        _Temperature(300)
     {
         //std::cout << "\n   *** No parameter map passes, using default cut values! ***" << std::endl;
     }
@@ -169,6 +193,42 @@ public:
     void SetCorrectBias(float val) { _CorrectBias = val;}
     const float & CorrectBias() const { return _CorrectBias;}
 
+    uint32_t BaselineMethod() { return _BaselineMethod;}
+    void SetBaselineMethod(uint32_t val) { _BaselineMethod = val;}
+    const uint32_t & BaselineMethod() const { return _BaselineMethod;}
+
+    float BaselineTrim() { return _BaselineTrim;}
+    void SetBaselineTrim(float val) { _BaselineTrim = val;}
+    const float & BaselineTrim() const { return _BaselineTrim;}
+
+    float BaselineTail() { return _BaselineTail;}
+    void SetBaselineTail(float val) { _BaselineTail = val;}
+    const float & BaselineTail() const { return _BaselineTail;}
+
+    bool IntegralTables() { return _IntegralTables;}
+    void SetIntegralTables(bool val) { _IntegralTables = val;}
+    const bool & IntegralTables() const { return _IntegralTables;}
+
+    bool FastFit() { return _FastFit;}
+    void SetFastFit(bool val) { _FastFit = val;}
+    const bool & FastFit() const { return _FastFit;}
+
+    bool FitContinuation() { return _FitContinuation;}
+    void SetFitContinuation(bool val) { _FitContinuation = val;}
+    const bool & FitContinuation() const { return _FitContinuation;}
+
+    uint32_t ReaderMode() { return _ReaderMode;}
+    void SetReaderMode(uint32_t val) { _ReaderMode = val;}
+    const uint32_t & ReaderMode() const { return _ReaderMode;}
+
+    uint32_t ReaderCache() { return _ReaderCache;}
+    void SetReaderCache(uint32_t val) { _ReaderCache = val;}
+    const uint32_t & ReaderCache() const { return _ReaderCache;}
+
+    uint32_t Threads() { return _Threads;}
+    void SetThreads(uint32_t val) { _Threads = val;}
+    const uint32_t & Threads() const { return _Threads;}
+
     //end scanning section
 
     //begin coeffiecients
@@ -179,6 +239,10 @@ public:
     void Setmu0_holes(float val) { _mu0_holes = val;}
     float v_sat() { return _v_sat; }
     void Setv_sat(float val) { _v_sat = val;}
+    uint32_t DriftModel() { return _DriftModel; }
+    void SetDriftModel(uint32_t val) { _DriftModel = val;}
+    float Temperature() { return _Temperature; }
+    void SetTemperature(float val) { _Temperature = val;}
     float ampl() { return _ampl; }
     void Setampl(float val) { _ampl = val;}
     float light_split() { return _light_split; }
@@ -198,6 +262,10 @@ public:
     void SetDataFolder(std::string val) { _DataFolder = val;}
     const std::string & DataFolder() const { return _DataFolder;}
 
+    std::string CacheFolder () { return _CacheFolder;}
+    void SetCacheFolder(std::string val) { _CacheFolder = val;}
+    const std::string & CacheFolder() const { return _CacheFolder;}
+
     void SetParameters(std::map<std::string, std::string> id_val);
 
     std::string OutFolder() {return _OutFolder;}
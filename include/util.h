@@ -13,6 +13,7 @@
 #include <fstream>
 #include <stdexcept>
 #include <map>
+#include <cstdio>
 
 
 namespace TCT {
@@ -34,5 +35,12 @@ namespace TCT {
       bool IsRead() { return _IsRead;}
 
   };
+
+  /// Order of the file names, runs of digits are compared as numbers (acq_2 before acq_10)
+  bool NaturalLess(const std::string &a, const std::string &b);
+
+  /// Voltages of an oscilloscope text file: a header of 30 words, then the time and the voltage of each sample.
+  /// The voltages are appended to volt, minvolt and maxvolt are moved to their extremes. False at a word that is not a number.
+  bool ParseSamples(FILE *infile, std::vector<double> &volt, float &minvolt, float &maxvolt);
 }
 #endif
@@ -0,0 +1,347 @@
+/**
+ * \file
+ * \brief Implementation of the TCTCatalog class.
+ *
+ */
+
+#include "TCTCatalog.h"
+#include "TCTReader.h"
+#include "TSystem.h"
+#include "TMath.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <map>
+
+TCTCatalog::TCTCatalog(const Char_t *folder, const Char_t *index)
+{
+    ////////////////////////////////////////////////////////////////////////////
+    // Catalog of the headers of the .tct files in a folder
+    //
+    // const Char_t *folder; folder with the .tct files
+    // const Char_t *index;  catalog file, <folder>/tct_catalog.txt if NULL
+    // Example of use :
+    // TCTCatalog cat("../testdata/lpnhe/");
+    // cat.Update();                                   // read the headers of new and changed files
+    // std::vector<Int_t> sel=cat.Select("Sample~X T=300 U>500");
+    // for(UInt_t i=0;i<sel.size();i++) cat.Print(sel[i]);
+    Folder=folder;
+    if(Folder.length()>0 && Folder[Folder.length()-1]!='/') Folder+="/";
+    if(index) IndexFile=index; else IndexFile=Folder+"tct_catalog.txt";
+}
+
+Bool_t TCTCatalog::Stat(const Char_t *file, Long64_t &size, Long64_t &mtime)
+{
+    // Gets the size and the time of the last modification of the file
+    struct stat st;
+    if(stat(file,&st)!=0) return kFALSE;
+    size=st.st_size;
+    mtime=st.st_mtime;
+    return kTRUE;
+}
+
+ULong64_t TCTCatalog::Hash(const Char_t *file)
+{
+    // Function returns the 64 bit FNV-1a hash of the content of the file (0 if it can not be read)
+    ULong64_t h=14695981039346656037ULL;
+    std::vector<unsigned char> buf(1<<20);
+    size_t n,i;
+    FILE *f=fopen(file,"rb");
+    if(f==NULL) return 0;
+    while((n=fread(&buf[0],1,buf.size(),f))>0)
+        for(i=0;i<n;i++) {h^=buf[i]; h*=1099511628211ULL;}
+    fclose(f);
+    return h;
+}
+
+Bool_t TCTCatalog::Fill(TCTCatalogEntry &e, const Char_t *name)
+{
+    // Reads the header of the file into the entry
+    std::string path=Folder+name;
+    Char_t pathandfile[1000];
+    Int_t i,t,bin=2;
+    FILE *f;
+    if(!Stat(path.c_str(),e.Size,e.MTime)) {printf("Can not access %s\n",path.c_str()); return kFALSE;}
+    strncpy(pathandfile,path.c_str(),sizeof(pathandfile)-1);
+    pathandfile[sizeof(pathandfile)-1]='\0';
+
+    // ASCII files start with the type written as text (type 11 exists only as ASCII), all others are
+    // read as little endian binary files, the same as the scans are read for the analysis
+    if((f=fopen(pathandfile,"r"))!=NULL)
+    {
+        if(fscanf(f,"%d",&t)==1 && (t==11 || t==22 || t==33 || t==51)) bin=0;
+        fclose(f);
+    }
+
+    TCTReader r(pathandfile,0,bin,5);
+    if(!(r.type==11 || r.type==22 || r.type==33 || r.type==51))
+    {
+        printf("%s is not a waveform file (type %d)\n",name,r.type);
+        return kFALSE;
+    }
+    e.Name=name;
+    e.Hash=Hash(path.c_str());
+    e.type=r.type;
+    for(i=0;i<6;i++) e.Date[i]=r.Date[i];
+    e.abstime=r.abstime;
+    e.T=r.T; e.Source=r.Source;
+    e.x0=r.x0; e.dx=r.dx; e.Nx=r.Nx;
+    e.y0=r.y0; e.dy=r.dy; e.Ny=r.Ny;
+    e.z0=r.z0; e.dz=r.dz; e.Nz=r.Nz;
+    e.t0=r.t0; e.dt=r.dt; e.NP=r.NP;
+    for(i=0;i<4;i++) e.WFOnOff[i]=r.WFOnOff[i];
+    e.U1.assign(r.U1.GetArray(),r.U1.GetArray()+r.NU1);
+    e.U2.assign(r.U2.GetArray(),r.U2.GetArray()+r.NU2);
+    // tabs and new lines would break the line of the catalog
+    e.User=r.User?r.User:"";
+    e.Sample=r.Sample?r.Sample:"";
+    e.Comment=r.Comment?r.Comment:"";
+    std::string *str[3]={&e.User,&e.Sample,&e.Comment};
+    for(i=0;i<3;i++) for(UInt_t j=0;j<str[i]->length();j++) if((*str[i])[j]=='\t' || (*str[i])[j]=='\n' || (*str[i])[j]=='\r') (*str[i])[j]=' ';
+    return kTRUE;
+}
+
+Bool_t TCTCatalog::Load()
+{
+    // Reads the catalog file, returns kFALSE if it does not exist
+    std::ifstream in(IndexFile.c_str());
+    std::string line;
+    Int_t i,n;
+    if(!in.is_open()) return kFALSE;
+    Entries.clear();
+    while(std::getline(in,line))
+    {
+        if(line.length()==0 || line[0]=='#') continue;
+        std::vector<std::string> f;
+        size_t b=0,e;
+        while((e=line.find('\t',b))!=std::string::npos) {f.push_back(line.substr(b,e-b)); b=e+1;}
+        f.push_back(line.substr(b));
+        if(f.size()!=5) {printf("Wrong line in the catalog %s\n",IndexFile.c_str()); continue;}
+
+        TCTCatalogEntry c;
+        std::istringstream num(f[1]);
+        c.Name=f[0];
+        num>>std::hex>>c.Hash>>std::dec>>c.Size>>c.MTime>>c.type;
+        for(i=0;i<6;i++) num>>c.Date[i];
+        num>>c.abstime>>c.T>>c.Source;
+        num>>c.x0>>c.dx>>c.Nx>>c.y0>>c.dy>>c.Ny>>c.z0>>c.dz>>c.Nz;
+        num>>c.t0>>c.dt>>c.NP;
+        for(i=0;i<4;i++) num>>c.WFOnOff[i];
+        num>>n; c.U1.resize(n>0?n:0); for(i=0;i<n;i++) num>>c.U1[i];
+        num>>n; c.U2.resize(n>0?n:0); for(i=0;i<n;i++) num>>c.U2[i];
+        if(num.fail()) {printf("Wrong line in the catalog %s\n",IndexFile.c_str()); continue;}
+        c.User=f[2]; c.Sample=f[3]; c.Comment=f[4];
+        Entries.push_back(c);
+    }
+    return kTRUE;
+}
+
+Bool_t TCTCatalog::Save()
+{
+    // Writes the catalog file
+    // The new catalog replaces the old one only when it is completely written.
+    std::string tmp=IndexFile+".tmp";
+    UInt_t i,j;
+    FILE *out=fopen(tmp.c_str(),"w");
+    if(out==NULL) {printf("Can not write the catalog %s\n",IndexFile.c_str()); return kFALSE;}
+    fprintf(out,"# TCT catalog: name hash size mtime type date[6] abstime T Source x0 dx Nx y0 dy Ny z0 dz Nz t0 dt NP WFOnOff[4] NU1 U1 NU2 U2 / User / Sample / Comment\n");
+    for(i=0;i<Entries.size();i++)
+    {
+        TCTCatalogEntry &e=Entries[i];
+        fprintf(out,"%s\t%llx %lld %lld %d",e.Name.c_str(),(unsigned long long)e.Hash,(long long)e.Size,(long long)e.MTime,e.type);
+        for(j=0;j<6;j++) fprintf(out," %d",e.Date[j]);
+        fprintf(out," %d %.9g %.9g",e.abstime,e.T,e.Source);
+        fprintf(out," %.9g %.9g %d %.9g %.9g %d %.9g %.9g %d",e.x0,e.dx,e.Nx,e.y0,e.dy,e.Ny,e.z0,e.dz,e.Nz);
+        fprintf(out," %.9g %.9g %d",e.t0,e.dt,e.NP);
+        for(j=0;j<4;j++) fprintf(out," %d",e.WFOnOff[j]);
+        fprintf(out," %d",(Int_t)e.U1.size()); for(j=0;j<e.U1.size();j++) fprintf(out," %.9g",e.U1[j]);
+        fprintf(out," %d",(Int_t)e.U2.size()); for(j=0;j<e.U2.size();j++) fprintf(out," %.9g",e.U2[j]);
+        fprintf(out,"\t%s\t%s\t%s\n",e.User.c_str(),e.Sample.c_str(),e.Comment.c_str());
+    }
+    if(fclose(out)!=0 || rename(tmp.c_str(),IndexFile.c_str())!=0)
+    {
+        printf("Can not write the catalog %s\n",IndexFile.c_str());
+        remove(tmp.c_str());
+        return kFALSE;
+    }
+    return kTRUE;
+}
+
+Int_t TCTCatalog::Update()
+{
+    // Brings the catalog up to date with the .tct files of the folder and saves it
+    // Only the headers of new files and of files with a different size or modification time are read,
+    // entries of removed files are dropped. Function returns the number of headers read.
+    std::map<std::string, Int_t> old;
+    std::vector<TCTCatalogEntry> upd;
+    std::vector<std::string> names;
+    const Char_t *infile;
+    Long64_t size,mtime;
+    Int_t nread=0;
+    UInt_t i;
+
+    Load();
+    for(i=0;i<Entries.size();i++) old[Entries[i].Name]=i;
+
+    void *dir=gSystem->OpenDirectory(Folder.c_str());
+    if(!dir) {printf("Can not open the folder %s\n",Folder.c_str()); return 0;}
+    while((infile=gSystem->GetDirEntry(dir)))
+    {
+        Int_t l=strlen(infile);
+        if(l>4 && strcmp(infile+l-4,".tct")==0) names.push_back(infile);
+    }
+    gSystem->FreeDirectory(dir);
+    std::sort(names.begin(),names.end());
+
+    for(i=0;i<names.size();i++)
+    {
+        if(!Stat((Folder+names[i]).c_str(),size,mtime)) continue;
+        if(old.count(names[i]))
+        {
+            TCTCatalogEntry &e=Entries[old[names[i]]];
+            if(e.Size==size && e.MTime==mtime) {upd.push_back(e); continue;}
+        }
+        TCTCatalogEntry e;
+        if(Fill(e,names[i].c_str())) {upd.push_back(e); nread++;}
+        else printf("Can not read the header of %s, not in the catalog\n",names[i].c_str());
+    }
+    Entries.swap(upd);
+    Save();
+    return nread;
+}
+
+Int_t TCTCatalog::Find(const Char_t *file)
+{
+    // Function returns the index of the entry of the file (with or without the path),
+    // or -1 if the file is not in the catalog or it was changed since the last update
+    const Char_t *name=strrchr(file,'/');
+    Long64_t size,mtime;
+    name=name?name+1:file;
+    for(UInt_t i=0;i<Entries.size();i++)
+    {
+        if(Entries[i].Name!=name) continue;
+        if(!Stat((Folder+name).c_str(),size,mtime)) return -1;
+        if(Entries[i].Size!=size || Entries[i].MTime!=mtime) return -1;
+        return i;
+    }
+    return -1;
+}
+
+Bool_t TCTCatalog::Match(TCTCatalogEntry &e, std::string &cond)
+{
+    // Checks one condition of the query: <key><op><value>
+    // keys: Name, User, Sample, Comment (op = equal, ~ contains)
+    //       T, U (absolute value of any of the voltages U1), U2, Nx, Ny, Nz, NP, type (op = < > <= >= =)
+    // Numbers are equal if they differ by less than 0.5.
+    size_t p=cond.find_first_of("<>=~");
+    if(p==0 || p==std::string::npos) {printf("Wrong condition %s\n",cond.c_str()); return kFALSE;}
+    std::string key=cond.substr(0,p);
+    std::string op=cond.substr(p,1);
+    if((op=="<" || op==">") && p+1<cond.length() && cond[p+1]=='=') op+="=";
+    std::string val=cond.substr(p+op.length());
+
+    std::string *str=NULL;
+    if(key=="Name") str=&e.Name;
+    if(key=="User") str=&e.User;
+    if(key=="Sample") str=&e.Sample;
+    if(key=="Comment") str=&e.Comment;
+    if(str)
+    {
+        if(op=="~") return str->find(val)!=std::string::npos;
+        return *str==val;
+    }
+
+    std::vector<Float_t> x;
+    Double_t v=atof(val.c_str());
+    if(key=="T") x.push_back(e.T);
+    else if(key=="U") for(UInt_t i=0;i<e.U1.size();i++) x.push_back(TMath::Abs(e.U1[i]));
+    else if(key=="U2") for(UInt_t i=0;i<e.U2.size();i++) x.push_back(e.U2[i]);
+    else if(key=="Nx") x.push_back(e.Nx);
+    else if(key=="Ny") x.push_back(e.Ny);
+    else if(key=="Nz") x.push_back(e.Nz);
+    else if(key=="NP") x.push_back(e.NP);
+    else if(key=="type") x.push_back(e.type);
+    else {printf("Unknown key %s\n",key.c_str()); return kFALSE;}
+
+    for(UInt_t i=0;i<x.size();i++)
+    {
+        if(op=="<" && x[i]<v) return kTRUE;
+        if(op==">" && x[i]>v) return kTRUE;
+        if(op=="<=" && x[i]<=v) return kTRUE;
+        if(op==">=" && x[i]>=v) return kTRUE;
+        if((op=="=" || op=="~") && TMath::Abs(x[i]-v)<0.5) return kTRUE;
+    }
+    return kFALSE;
+}
+
+std::vector<Int_t> TCTCatalog::Select(const Char_t *query)
+{
+    // Function returns the indices of the entries fulfilling all conditions of the query
+    // const Char_t *query; conditions separated by spaces, e.g. "Sample~X T=300 U>500" (see Match)
+    std::vector<std::string> cond;
+    std::vector<Int_t> sel;
+    std::istringstream q(query);
+    std::string c;
+    UInt_t i,j;
+    while(q>>c) cond.push_back(c);
+    for(i=0;i<Entries.size();i++)
+    {
+        for(j=0;j<cond.size();j++) if(!Match(Entries[i],cond[j])) break;
+        if(j==cond.size()) sel.push_back(i);
+    }
+    return sel;
+}
+
+void TCTCatalog::Print(Int_t i)
+{
+    // Prints one line about the file
+    TCTCatalogEntry &e=Entries[i];
+    Float_t umin=0,umax=0;
+    for(UInt_t j=0;j<e.U1.size();j++)
+    {
+        if(j==0 || e.U1[j]<umin) umin=e.U1[j];
+        if(j==0 || e.U1[j]>umax) umax=e.U1[j];
+    }
+    printf("%s: Sample=%s T=%.1f U1=%d(%.1f..%.1f) X=%d Y=%d Z=%d date %d.%d.%d %d:%d:%d\n",e.Name.c_str(),e.Sample.c_str(),e.T,
+           (Int_t)e.U1.size(),umin,umax,e.Nx,e.Ny,e.Nz,e.Date[0],e.Date[1],e.Date[2],e.Date[3],e.Date[4],e.Date[5]);
+}
+
+std::string TCTCatalog::StringInfo(Int_t i)
+{
+    // Function returns the information about the file in the format of TCTReader::StringInfo (without currents)
+    TCTCatalogEntry &e=Entries[i];
+    std::string output;
+    char buffer[250];
+    sprintf(buffer,"<b>Format of the file: </b>%d",e.type);
+    output = std::string(buffer);
+    if(e.User.length()) output += "<p><b>User: </b>" + e.User;
+    if(e.Sample.length()) output += "<p><b>Sample: </b>" + e.Sample;
+    if(e.Comment.length()) output += "<p><b>Comment: </b>" + e.Comment;
+    sprintf(buffer,"<p><b>Date and time of the meaurement:</b> %d.%d.%d %d:%d:%d",e.Date[0],e.Date[1],e.Date[2],e.Date[3],e.Date[4],e.Date[5]);
+    output += std::string(buffer);
+    sprintf(buffer,"<p><b>Active osciloscope channels:</b> Ch1=%d Ch2=%d Ch3=%d Ch4=%d",e.WFOnOff[0],e.WFOnOff[1],e.WFOnOff[2],e.WFOnOff[3]);
+    output += std::string(buffer);
+    sprintf(buffer,"<p><b>Number of points:</b> %d (X=%d, Y=%d, Z=%d)",e.Nx*e.Ny*e.Nz,e.Nx,e.Ny,e.Nz);
+    output += std::string(buffer);
+    sprintf(buffer,"<p><b>Positions:</b> r0=(%f,%f,%f) dr=(%f,%f,%f) ",e.x0,e.y0,e.z0,e.dx,e.dy,e.dz);
+    output += std::string(buffer);
+    sprintf(buffer,"<p><b>Time scale:</b> points=%d, t0=%e, dt=%e",e.NP,e.t0,e.dt);
+    output += std::string(buffer);
+    sprintf(buffer,"<p><b>Temperature:</b> %f",e.T);
+    output += std::string(buffer);
+    sprintf(buffer,"<p><b>Type of generation:</b> %4.0f",e.Source);
+    output += std::string(buffer);
+    sprintf(buffer,"<p><b>Voltages:</b> NU1=%d , NU2=%d:",(Int_t)e.U1.size(),(Int_t)e.U2.size());
+    output += std::string(buffer);
+    for(UInt_t j=0;j<e.U1.size();j++)
+        for(UInt_t k=0;k<e.U2.size();k++)
+        {
+            sprintf(buffer,"<p>U1,U2(%f,%f)",e.U1[j],e.U2[k]);
+            output += std::string(buffer);
+        }
+    return output;
+}
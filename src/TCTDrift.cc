@@ -0,0 +1,194 @@
+/**
+ * \file
+ * \brief Implementation of TCT::DriftModel methods.
+ */
+
+// STD includes
+#include <cmath>
+#include <iostream>
+
+// TCT includes
+#include "TCTDrift.h"
+#include "tct_config.h"
+
+namespace TCT {
+
+DriftModel::DriftModel(tct_config *config, int n, double Emax) {
+    Init(config->DriftModel(),config->mu0_els(),config->mu0_holes(),config->v_sat(),config->Temperature(),n,Emax);
+}
+
+DriftModel::DriftModel(int model, double mu0_els, double mu0_holes, double v_sat, double T, int n, double Emax) {
+    Init(model,mu0_els,mu0_holes,v_sat,T,n,Emax);
+}
+
+const char* DriftModel::ModelName(int model) {
+    switch(model) {
+    case kCanali: return "Canali";
+    case kJacoboni: return "Jacoboni";
+    default: return "Config";
+    }
+}
+
+/// Parameters of the model and the tables
+void DriftModel::Init(int model, double mu0_els, double mu0_holes, double v_sat, double T, int n, double Emax) {
+    /** \param[in] n Number of points of each table
+     *  \param[in] Emax Largest field in the tables, V/cm
+     */
+    fModel = model;
+    fEmax = Emax;
+    if(n<2) n = 2;
+    switch(model) {
+    case kCanali: // Canali et al., IEEE Trans. Electron Devices 22 (1975) 1045
+        fMu0[kElectron] = mu0_els;
+        fMu0[kHole] = mu0_holes;
+        fVsat[kElectron] = 1.07e7*pow(T/300.,-0.87);
+        fVsat[kHole] = 8.37e6*pow(T/300.,-0.52);
+        fBeta[kElectron] = 1.109*pow(T/300.,0.66);
+        fBeta[kHole] = 1.213*pow(T/300.,0.17);
+        break;
+    case kJacoboni: // Jacoboni et al., Solid-State Electronics 20 (1977) 77
+        fVsat[kElectron] = 1.53e9*pow(T,-0.87);
+        fVsat[kHole] = 1.62e8*pow(T,-0.52);
+        fMu0[kElectron] = fVsat[kElectron]/(1.01*pow(T,1.55));
+        fMu0[kHole] = fVsat[kHole]/(1.24*pow(T,1.68));
+        fBeta[kElectron] = 2.57e-2*pow(T,0.66);
+        fBeta[kHole] = 0.46*pow(T,0.17);
+        break;
+    default:
+        if(model!=kConfig) std::cout<<"Unknown drift model "<<model<<", using "<<ModelName(kConfig)<<std::endl;
+        fModel = kConfig;
+        fMu0[kElectron] = mu0_els;
+        fMu0[kHole] = mu0_holes;
+        fVsat[kElectron] = fVsat[kHole] = v_sat;
+        fBeta[kElectron] = 2;
+        fBeta[kHole] = 1;
+    }
+
+    for(int c=0;c<2;c++) {
+        Table &v = fVel[c], &m = fMob[c];
+        v.step = m.step = Emax/(n-1);
+        v.odd = true;
+        m.odd = false;
+        v.y.resize(n); v.dy.resize(n);
+        m.y.resize(n); m.dy.resize(n);
+        for(int k=0;k<n;k++) {
+            v.y[k] = ExactVelocity(k*v.step,c,&v.dy[k]);
+            m.y[k] = ExactMobility(k*m.step,c,&m.dy[k]);
+        }
+    }
+
+    // inverse of the sum of the velocities at equidistant sums, the field of each node is
+    // found with Newton steps bracketed by the field of the previous node and Emax
+    fUmax = ExactVelocity(Emax,kElectron)+ExactVelocity(Emax,kHole);
+    fInv.step = fUmax/(n-1);
+    fInv.odd = true;
+    fInv.y.resize(n); fInv.dy.resize(n);
+    double lo = 0, E = 0, f, se, sh;
+    for(int k=0;k<n;k++) {
+        double u = k*fInv.step, hi = Emax;
+        if(k==n-1) E = Emax;
+        else for(int it=0;it<100;it++) {
+            f = ExactVelocity(E,kElectron,&se)+ExactVelocity(E,kHole,&sh)-u;
+            double s = se+sh;
+            if(f==0) break;
+            if(f<0) lo = E;
+            else hi = E;
+            double next = E-f/s;
+            if(!(next>lo && next<hi)) next = 0.5*(lo+hi);
+            if(fabs(next-E)<=1e-13*(1+E)) { E = next; break; }
+            E = next;
+        }
+        ExactVelocity(E,kElectron,&se);
+        ExactVelocity(E,kHole,&sh);
+        fInv.y[k] = E;
+        fInv.dy[k] = 1./(se+sh);
+        lo = E;
+    }
+}
+
+/// Drift velocity
+double DriftModel::ExactVelocity(double E, int type, double *slope) const {
+    /** \param[in] E Electric field
+     *  \param[in] type Charge carrier type. 1 - hole, 0 - electron.
+     *  \param[out] slope Derivative with respect to E, if not NULL
+     */
+    double x = fMu0[type]*fabs(E)/fVsat[type];
+    double r = fBeta[type]==1 ? 1+x : (fBeta[type]==2 ? 1+x*x : 1+pow(x,fBeta[type]));
+    double p = fBeta[type]==1 ? r : (fBeta[type]==2 ? sqrt(r) : pow(r,1./fBeta[type]));
+    if(slope) *slope = fMu0[type]/(p*r);
+    return fMu0[type]*E/p;
+}
+
+/// Mobility with field
+double DriftModel::ExactMobility(double E, int type, double *slope) const {
+    /** \param[in] E Electric field
+     *  \param[in] type Charge carrier type. 1 - hole, 0 - electron.
+     *  \param[out] slope Derivative with respect to E, if not NULL
+     */
+    double x = fMu0[type]*fabs(E)/fVsat[type];
+    double r = 1+pow(x,fBeta[type]);
+    double mu = fMu0[type]/pow(r,1./fBeta[type]);
+    if(slope) {
+        // at E=0 the slope is finite only for beta>=1, otherwise the node keeps the slope 0
+        if(x>0) *slope = -mu/r*pow(x,fBeta[type]-1)*fMu0[type]/fVsat[type];
+        else *slope = fBeta[type]==1 ? -fMu0[type]*fMu0[type]/fVsat[type] : 0;
+        if(E<0) *slope = -*slope;
+    }
+    return mu;
+}
+
+/// Cubic Hermite interpolation of the table
+double DriftModel::Interpolate(const Table &t, double x, double *slope) const {
+    int n = t.y.size();
+    double ax = fabs(x);
+    double sign = (x<0 && t.odd) ? -1 : 1;
+    double pos = ax/t.step;
+    if(!(pos<n-1)) {
+        if(slope) *slope = (x<0 && !t.odd) ? -t.dy[n-1] : t.dy[n-1];
+        return sign*t.y[n-1];
+    }
+    int k = (int)pos;
+    double u = pos-k, u2 = u*u, u3 = u2*u;
+    double y0 = t.y[k], y1 = t.y[k+1], d0 = t.dy[k]*t.step, d1 = t.dy[k+1]*t.step;
+    if(slope) {
+        *slope = ((6*u2-6*u)*(y0-y1)+(3*u2-4*u+1)*d0+(3*u2-2*u)*d1)/t.step;
+        if(x<0 && !t.odd) *slope = -*slope;
+    }
+    return sign*((2*u3-3*u2+1)*y0+(u3-2*u2+u)*d0+(-2*u3+3*u2)*y1+(u3-u2)*d1);
+}
+
+double DriftModel::VelocitySum(double E, double *slope) const {
+    if(!slope) return Interpolate(fVel[kElectron],E)+Interpolate(fVel[kHole],E);
+    double se, sh;
+    double v = Interpolate(fVel[kElectron],E,&se)+Interpolate(fVel[kHole],E,&sh);
+    *slope = se+sh;
+    return v;
+}
+
+double DriftModel::Field(double u) const {
+    /** Interpolation of the inverse table followed by one Newton step on the velocity tables,
+     *  so that VelocitySum(Field(u)) = u to the precision of the tables.
+     */
+    double E = Interpolate(fInv,u);
+    if(!(fabs(u)<fUmax)) return E;
+    double s;
+    double f = VelocitySum(E,&s)-u;
+    if(s>0) E -= f/s;
+    if(E>fEmax) E = fEmax;
+    if(E<-fEmax) E = -fEmax;
+    return E;
+}
+
+void DriftModel::Velocity(int n, const double *E, int type, double *v) const {
+    for(int i=0;i<n;i++) v[i] = Interpolate(fVel[type],E[i]);
+}
+
+void DriftModel::Mobility(int n, const double *E, int type, double *mu) const {
+    for(int i=0;i<n;i++) mu[i] = Interpolate(fMob[type],E[i]);
+}
+
+void DriftModel::Field(int n, const double *u, double scale, double *E) const {
+    for(int i=0;i<n;i++) E[i] = Field(scale*u[i]);
+}
+
+}
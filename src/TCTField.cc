@@ -0,0 +1,87 @@
+/**
+ * \file
+ * \brief Implementation of the field solver of the edge-TCT.
+ */
+
+// STD includes
+#include <cmath>
+#include <algorithm>
+
+// TCT includes
+#include "TCTField.h"
+
+namespace TCT {
+
+/// Field profile for the normalisation constant a
+double FieldProfile(const DriftModel &drift, int n, const double *charge, int ix1, int ix2, double Ss, double a, double *field) {
+    /** Solves \f$charge = a*(v_{els}(field)+v_{holes}(field))\f$ in each point,
+     *  the field is limited to -5e3 - 1e6 V/cm.
+     *  \param[in] Ss Step of the scan in um
+     *  \return Integral of the field between ix1 and ix2, the voltage on the sensor
+     */
+    double sum = 0;
+    drift.Field(n,charge,1./a,field);
+    for(int i=0;i<n;i++) if(field[i]<-5e3) field[i] = -5e3;
+    for(int i=ix1;i<=ix2;i++) sum+=field[i];
+    return sum*1e-4*Ss; // conversion from um to cm
+}
+
+/// Normalisation constant for which the field integrates to the bias voltage
+bool Normalisation(const DriftModel &drift, double U, int n, const double *charge, int ix1, int ix2, double Ss, double &a, double eps, double *field) {
+    /** The voltage falls with |a|. The root is bracketed starting from a (its sign is kept)
+     *  and found with Brent's method to the precision eps in voltage.
+     *  \param[in,out] a Start value, the constant found on return
+     *  \param[out] field Field profile for the returned constant
+     *  \return false if no constant gives the voltage U within eps, a and field are then those of the last try
+     */
+    double sign = a<0 ? -1 : 1;
+    double b = fabs(a), c, fb, fc;
+    fb = FieldProfile(drift,n,charge,ix1,ix2,Ss,sign*b,field)-U;
+    c = b;
+    fc = fb;
+    for(int it=0;it<200 && (fb>0)==(fc>0);it++) {
+        c = fb>0 ? 2*c : c/2;
+        fc = FieldProfile(drift,n,charge,ix1,ix2,Ss,sign*c,field)-U;
+    }
+    if((fb>0)==(fc>0)) {
+        a = sign*c;
+        return false;
+    }
+    // Brent's method on [b,c]
+    double aa = b, fa = fb, d, e;
+    b = c; fb = fc;
+    c = aa; fc = fa;
+    d = e = b-aa;
+    for(int it=0;it<100;it++) {
+        if((fb>0)==(fc>0)) { c = aa; fc = fa; d = e = b-aa; }
+        if(fabs(fc)<fabs(fb)) { aa = b; b = c; c = aa; fa = fb; fb = fc; fc = fa; }
+        double tol = 1e-15*fabs(b);
+        double xm = 0.5*(c-b);
+        if(fabs(fb)<=eps || fabs(xm)<=tol) break;
+        if(fabs(e)>=tol && fabs(fa)>fabs(fb)) {
+            // inverse quadratic interpolation or secant
+            double p, q, r, s = fb/fa;
+            if(aa==c) { p = 2*xm*s; q = 1-s; }
+            else {
+                q = fa/fc; r = fb/fc;
+                p = s*(2*xm*q*(q-r)-(b-aa)*(r-1));
+                q = (q-1)*(r-1)*(s-1);
+            }
+            if(p>0) q = -q;
+            p = fabs(p);
+            if(2*p<std::min(3*xm*q-fabs(tol*q),fabs(e*q))) { e = d; d = p/q; }
+            else { d = xm; e = d; }
+        }
+        else { d = xm; e = d; }
+        aa = b; fa = fb;
+        b += fabs(d)>tol ? d : (xm>0 ? tol : -tol);
+        fb = FieldProfile(drift,n,charge,ix1,ix2,Ss,sign*b,field)-U;
+    }
+    // the last evaluation may have been at the other end of the bracket
+    FieldProfile(drift,n,charge,ix1,ix2,Ss,sign*b,field);
+    a = sign*b;
+    // not reached if the bracket shrank to the rounding of a, or the iterations ran out, before eps
+    return fabs(fb)<=eps;
+}
+
+}
@@ -0,0 +1,182 @@
+/**
+ * \file
+ * \brief Implementation of TCT::Fitter methods.
+ */
+
+// STD includes
+#include <cmath>
+#include <vector>
+
+// TCT includes
+#include "TCTFitter.h"
+
+namespace TCT {
+
+// derivative of erf(u) with respect to u
+static inline double ErfSlope(double u) { return 1.1283791670955126*exp(-u*u); }
+
+double ErfcEdgeModel::Eval(double x, const double *par, double *grad) const {
+    double u = (x-par[0])/par[1];
+    double e = erfc(u);
+    if(grad) {
+        double g = ErfSlope(u);
+        grad[0] = -par[2]*g/par[1];
+        grad[1] = -par[2]*g*u/par[1];
+        grad[2] = -e;
+        grad[3] = 1;
+    }
+    return -par[2]*e+par[3];
+}
+
+double ErfEdgeModel::Eval(double x, const double *par, double *grad) const {
+    double u = (x-par[0])/par[1];
+    double e = erf(u);
+    if(grad) {
+        double g = ErfSlope(u);
+        grad[0] = par[2]*g/par[1];
+        grad[1] = par[2]*g*u/par[1];
+        grad[2] = -e;
+        grad[3] = 1;
+    }
+    return -par[2]*e+par[3];
+}
+
+double StripModel::Eval(double x, const double *par, double *grad) const {
+    double u = (x-par[0])/par[1];
+    double v = (x-par[0]-par[3])/par[1];
+    double s = erfc(u)+erf(v)+1;
+    if(grad) {
+        double gu = ErfSlope(u);
+        double gv = ErfSlope(v);
+        grad[0] = par[2]/2.*(gu-gv)/par[1];
+        grad[1] = par[2]/2.*(gu*u-gv*v)/par[1];
+        grad[2] = s/2.;
+        grad[3] = -par[2]/2.*gv/par[1];
+    }
+    return par[2]/2.*s;
+}
+
+Fitter::Fitter(const FitModel &model):
+    fModel(model),
+    fMaxIter(200),
+    fTolerance(1e-10),
+    fChi2(0),
+    fNDF(0),
+    fNPoints(0),
+    fIter(0)
+{
+    for(int i=0;i<MaxPar;i++) fErr[i] = 0;
+}
+
+/// Chi2 of the points and, if A is not NULL, the normal equations J^T J and J^T r
+double Fitter::Normal(int n, const double *x, const double *y, const double *par, double *A, double *b) const {
+    int np = fModel.NPar();
+    double grad[MaxPar];
+    double chi2 = 0, r;
+    if(A) for(int i=0;i<np*np;i++) A[i] = 0;
+    if(b) for(int i=0;i<np;i++) b[i] = 0;
+    for(int k=0;k<n;k++) {
+        r = y[k]-fModel.Eval(x[k],par,A ? grad : 0);
+        chi2 += r*r;
+        if(!A) continue;
+        for(int i=0;i<np;i++) {
+            b[i] += grad[i]*r;
+            for(int j=0;j<=i;j++) A[i*np+j] += grad[i]*grad[j];
+        }
+    }
+    if(A) for(int i=0;i<np;i++) for(int j=0;j<i;j++) A[j*np+i] = A[i*np+j];
+    return chi2;
+}
+
+/// Solves (A + lambda*diag(A)) dp = b by Cholesky decomposition
+bool Fitter::Solve(int np, const double *A, const double *b, double lambda, double *dp) {
+    double L[MaxPar*MaxPar];
+    double s;
+    for(int i=0;i<np;i++)
+        for(int j=0;j<=i;j++) {
+            s = A[i*np+j];
+            if(i==j) s += lambda*(A[i*np+i]>0 ? A[i*np+i] : 1e-12);
+            for(int k=0;k<j;k++) s -= L[i*np+k]*L[j*np+k];
+            if(i==j) {
+                if(!(s>0)) return false;
+                L[i*np+i] = sqrt(s);
+            }
+            else L[i*np+j] = s/L[j*np+j];
+        }
+    for(int i=0;i<np;i++) {
+        s = b[i];
+        for(int k=0;k<i;k++) s -= L[i*np+k]*dp[k];
+        dp[i] = s/L[i*np+i];
+    }
+    for(int i=np-1;i>=0;i--) {
+        s = dp[i];
+        for(int k=i+1;k<np;k++) s -= L[k*np+i]*dp[k];
+        dp[i] = s/L[i*np+i];
+    }
+    return true;
+}
+
+/// Inverse of the symmetric positive definite matrix A (covariance of the parameters)
+bool Fitter::Invert(int np, const double *A, double *inv) {
+    double e[MaxPar], col[MaxPar];
+    for(int c=0;c<np;c++) {
+        for(int i=0;i<np;i++) e[i] = (i==c);
+        if(!Solve(np,A,e,0,col)) return false;
+        for(int i=0;i<np;i++) inv[i*np+c] = col[i];
+    }
+    return true;
+}
+
+/// Fit of the model
+bool Fitter::Fit(int n, const double *x, const double *y, double xmin, double xmax, double *par) {
+    /** Levenberg-Marquardt minimisation of the sum of squared residuals with the analytic
+     *  derivatives of the model. As for a TGraph without errors fitted by ROOT, all points have
+     *  equal weights and the parameter errors are scaled with sqrt(chi2/ndf).
+     *  \param[in] n Number of points
+     *  \param[in] x, y Points
+     *  \param[in] xmin, xmax Fit range
+     *  \param[in,out] par Start values of the parameters, the fitted values on return
+     *  \return false if there are not enough points or the fit did not converge
+     */
+    int np = fModel.NPar();
+    double A[MaxPar*MaxPar], b[MaxPar], dp[MaxPar], trial[MaxPar], cov[MaxPar*MaxPar];
+    double chi2, chi2_new, lambda = 1e-3;
+    bool converged = false;
+    std::vector<double> xs, ys;
+
+    for(int k=0;k<n;k++)
+        if(x[k]>=xmin && x[k]<=xmax) { xs.push_back(x[k]); ys.push_back(y[k]); }
+    fNPoints = xs.size();
+    fNDF = fNPoints-np;
+    fIter = 0;
+    for(int i=0;i<np;i++) fErr[i] = 0;
+    if(fNPoints==0) { fChi2 = 0; return false; }
+
+    chi2 = Normal(fNPoints,&xs[0],&ys[0],par,A,b);
+    for(fIter=0;fIter<fMaxIter && !converged;fIter++) {
+        // increase the damping until the step lowers the chi2
+        for(;;) {
+            if(!Solve(np,A,b,lambda,dp)) { lambda *= 10; if(lambda>1e16) break; continue; }
+            for(int i=0;i<np;i++) trial[i] = par[i]+dp[i];
+            chi2_new = Normal(fNPoints,&xs[0],&ys[0],trial,0,0);
+            if(chi2_new==chi2_new && chi2_new<=chi2) break;
+            lambda *= 10;
+            if(lambda>1e16) break;
+        }
+        if(lambda>1e16) { converged = true; break; } // no step lowers the chi2: at the minimum
+        double step = 0, size = 0;
+        for(int i=0;i<np;i++) { step += dp[i]*dp[i]; size += par[i]*par[i]; par[i] = trial[i]; }
+        converged = (chi2-chi2_new)<=fTolerance*chi2 || step<=fTolerance*fTolerance*(size+fTolerance);
+        chi2 = Normal(fNPoints,&xs[0],&ys[0],par,A,b);
+        lambda = lambda/10>1e-12 ? lambda/10 : 1e-12;
+    }
+    fChi2 = chi2;
+
+    if(Invert(np,A,cov)) {
+        double scale = fNDF>0 ? chi2/fNDF : 1;
+        for(int i=0;i<np;i++) fErr[i] = cov[i*np+i]>0 ? sqrt(cov[i*np+i]*scale) : 0;
+    }
+    return converged;
+}
+
+}
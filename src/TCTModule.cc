@@ -7,6 +7,9 @@
 #include<string>
 #include<sstream>
 #include<iostream>
+#include<vector>
+#include<thread>
+#include<atomic>
 
 // TCT includes
 #include "TCTModule.h"
@@ -19,6 +22,7 @@
 #include "TMath.h"
 #include "TSystem.h"
 #include "TFitResultPtr.h"
+#include "TFitResult.h"
 #include "TStyle.h"
 #include "TImage.h"
 #include "TDirectory.h"
@@ -83,24 +87,48 @@ void TCTModule::SwitchAxis(Int_t sw, Int_t& nPoints, Float_t& step, Float_t& p0)
 
 /// Calculate Charges for given Waveforms
 void TCTModule::CalculateCharges(Int_t Channel, Int_t Ax, Int_t numAx, Int_t scanning, Int_t numS, TGraph **charges, Float_t tstart, Float_t tfinish) {
-    TCTWaveform **wf = new TCTWaveform*[numAx];
+    /** The graphs are the charge profiles along the scanning axis, one for each point of the Ax axis,
+     *  the same as TCTWaveform::CCE of the projections (Projection(Channel,scanning,...)),
+     *  but made from views of the waveforms (see ChargeProfile), so no waveform is copied.
+     */
+    Int_t pos[5];
     for(int j=0;j<numAx;j++)
     {
-        switch(Ax)
-        {
-        case 0: wf[j]=stct->Projection(Channel,scanning,j,0,0,0,0,numS); break;
-        case 1: wf[j]=stct->Projection(Channel,scanning,0,j,0,0,0,numS); break;
-        case 2: wf[j]=stct->Projection(Channel,scanning,0,0,j,0,0,numS); break;
-        case 3: wf[j]=stct->Projection(Channel,scanning,0,0,0,j,0,numS); break;
-        case 4: wf[j]=stct->Projection(Channel,scanning,0,0,0,0,j,numS); break;
-        }
+        for(int k=0;k<5;k++) pos[k] = 0;
+        pos[Ax] = j;
+        charges[j] = ChargeProfile(stct->View(Channel,scanning,pos[0],pos[1],pos[2],pos[3],pos[4],numS),tstart,tfinish);
+    }
+}
 
-        wf[j]->SetTemperatures(stct->T);
-        charges[j]=wf[j]->CCE(tstart,tfinish);   //integrate the charge in time window
-        //wf[j]->Clear();
-        delete wf[j];
+/// Charge profile along a view of the waveforms
+TGraph* TCTModule::ChargeProfile(const TCTView &view, Float_t tstart, Float_t tfinish) {
+    /** The charges are taken from the charge map of the channel (TCTReader::ChargeMap), which is
+     *  integrated once for all waveforms and shared by all modules using the same time window.
+     *  The graph (points, style and title) is the same as TCTWaveform::CCE of the projection.
+     */
+    Char_t v[6];
+    TString title;
+    Int_t n = view.GetN();
+    TGraph *gr = new TGraph(n);
+    Double_t *xx = gr->GetX();
+    Double_t *yy = gr->GetY();
+
+    // several files processed at the same time already use all cores
+    const Float_t *map = stct->ChargeMap(view.GetChannel(),tstart,tfinish,config->Threads()>1 ? 1 : 0);
+
+    for(int i=0;i<n;i++) {
+        xx[i] = view.Abscissa(i);
+        yy[i] = map[view.Index(i)];
     }
-    delete wf;
+
+    TCTWaveform::int2ascii(v,stct->T);
+    title = "Charge vs. Voltage @ T="; title = title+v; title = title+" C";
+    gr->SetLineColor(2);
+    gr->SetLineWidth(4);
+    gr->SetMarkerColor(4);
+    gr->SetMarkerStyle(21);
+    gr->SetTitle((const char *)title);
+    return gr;
 }
 
 /// Calculate Normed Charges
@@ -109,9 +137,7 @@ TGraph** TCTModule::NormedCharge(TGraph** sensor, TGraph** photodiode, Int_t num
     TGraph** normed_charge = new TGraph*[numP];
     Int_t numS = sensor[0]->GetN();
 
-    Double_t *temp_sensor;
     Double_t *temp_diode;
-    Double_t *temp_normed = new Double_t[numS];
     Double_t temp_sr = 0;
     Double_t temp_sr_general = 0;
     for(int j=0;j<numP;j++) {
@@ -126,20 +152,35 @@ TGraph** TCTModule::NormedCharge(TGraph** sensor, TGraph** photodiode, Int_t num
 
     temp_sr_general=temp_sr_general/numP;
 
-    for(int j=0;j<numP;j++) {
-        temp_sensor = sensor[j]->GetY();
-        temp_diode = photodiode[j]->GetY();
-        for(int i=0;i<numS;i++) {
-            temp_normed[i] = temp_sr_general*temp_sensor[i]/temp_diode[i];
-        }
-        normed_charge[j] = new TGraph(numS,sensor[0]->GetX(),temp_normed);
-    }
+    // the profiles are normed in parallel, the graphs are made afterwards
+    std::vector<Double_t> normed((Long64_t)numP*numS);
+    ParallelFor(numP,[&](Int_t j) {
+        Double_t *s = sensor[j]->GetY();
+        Double_t *d = photodiode[j]->GetY();
+        Double_t *out = &normed[(Long64_t)j*numS];
+        for(int i=0;i<numS;i++) out[i] = temp_sr_general*s[i]/d[i];
+    },numS);
+    for(int j=0;j<numP;j++) normed_charge[j] = new TGraph(numS,sensor[0]->GetX(),&normed[(Long64_t)j*numS]);
 
-    delete temp_normed;
     return normed_charge;
 
 }
 
+/// Key of a result computed from a graph, for TCTReader::SetProduct
+ULong64_t TCTModule::ProductKey(const char* what, TGraph* gr, Int_t n, Double_t p1, Double_t p2) {
+    /** FNV-1a hash of the name of the result, the points of the graph and the parameters.
+     *  Equal keys mean equal inputs, so the stored result can be reused.
+     */
+    ULong64_t h = 14695981039346656037ULL;
+    const unsigned char* c;
+    Double_t par[3] = {(Double_t)n,p1,p2};
+    for(c = (const unsigned char*)what; *c; c++) {h ^= *c; h *= 1099511628211ULL;}
+    for(c = (const unsigned char*)par; c < (const unsigned char*)(par+3); c++) {h ^= *c; h *= 1099511628211ULL;}
+    for(c = (const unsigned char*)gr->GetX(); c < (const unsigned char*)(gr->GetX()+gr->GetN()); c++) {h ^= *c; h *= 1099511628211ULL;}
+    for(c = (const unsigned char*)gr->GetY(); c < (const unsigned char*)(gr->GetY()+gr->GetN()); c++) {h ^= *c; h *= 1099511628211ULL;}
+    return h;
+}
+
 /// Find position of two edge for a fixed voltage (at least fully depleted) and for one optical distance
 void TCTModule::FindEdges(TGraph* gr, Int_t numS, Float_t dx, Double_t& left_edge, Double_t& right_edge) {
 
@@ -152,6 +193,17 @@ void TCTModule::FindEdges(TGraph* gr, Int_t numS, Float_t dx, Double_t& left_edg
     Float_t max, min;
     Float_t FitHeight;
 
+    // the same profile was already fitted by another module
+    std::vector<Double_t> edges;
+    ULong64_t key = ProductKey(config->FastFit() ? "edges_lm" : "edges",gr,numS,dx,FWHM);
+    if(stct->GetProduct(key,edges)) {
+        left_edge = edges[0];
+        right_edge = edges[1];
+        delete ff_left;
+        delete ff_right;
+        return;
+    }
+
     yy_temp = gr->GetY();
     max = yy_temp[0];
     min = yy_temp[0];
@@ -175,11 +227,20 @@ void TCTModule::FindEdges(TGraph* gr, Int_t numS, Float_t dx, Double_t& left_edg
     SetFitParameters(ff_right,i_right*dx,FWHM,FitHeight,FitHeight);
     ff_right->SetRange((i_left+i_right)/2*dx,dx*numS);
 
-    gr->Fit("ff_left","NRq");
-    gr->Fit("ff_right","NRq+");
+    if(config->FastFit()) {
+        FitGraph(gr,ff_left,ErfcEdgeModel(),false);
+        FitGraph(gr,ff_right,ErfEdgeModel(),false);
+    }
+    else {
+        gr->Fit("ff_left","NRq");
+        gr->Fit("ff_right","NRq+");
+    }
 
     left_edge=ff_left->GetParameter(0);
     right_edge=ff_right->GetParameter(0);
+    edges.push_back(left_edge);
+    edges.push_back(right_edge);
+    stct->SetProduct(key,edges);
 
     delete ff_left;
     delete ff_right;
@@ -188,6 +249,10 @@ void TCTModule::FindEdges(TGraph* gr, Int_t numS, Float_t dx, Double_t& left_edg
 
 /// Find position of two edge for a fixed voltage (at least fully depleted) and for all optical distances
 void TCTModule::FindEdges(TGraph** gr, Int_t numP, Int_t numS, Float_t dx, Float_t* left_pos, Float_t* left_width, Float_t* right_pos, Float_t* right_width) {
+    /** With Minuit the positions are fitted one after the other in this thread (ROOT 5 can not fit
+     *  in threads). With FastFit the fits do not use ROOT, so the positions are split among threads
+     *  and the fitted functions are stored with the graphs afterwards, as by TGraph::Fit.
+     */
 
     TF1 *ff_left=new TF1("ff_left","-[2]*TMath::Erfc((x-[0])/[1])+[3]",0,dx*numS);
     ff_left->SetParName(0,"Left edge");
@@ -197,48 +262,270 @@ void TCTModule::FindEdges(TGraph** gr, Int_t numP, Int_t numS, Float_t dx, Float
     ff_right->SetParName(0,"Right edge");
     ff_right->SetParName(1,"#sigma_right");
 
-    double *yy_temp;
     Float_t FWHM = config->FFWHM();
-    Int_t i_left, i_right, i_max_val;
-    Float_t max, min;
-    Float_t FitHeight;
 
-    for(Int_t j=0;j<numP;j++) {
+    if(!config->FastFit() && !config->FitContinuation()) {
+        double *yy_temp;
+        Int_t i_left, i_right, i_max_val;
+        Float_t max, min;
+        Float_t FitHeight;
 
-        yy_temp = gr[j]->GetY();
-        max = yy_temp[0];
-        min = yy_temp[0];
+        for(Int_t j=0;j<numP;j++) {
 
-        for(int i=0;i<numS;i++) {
-            if(yy_temp[i]>max) {
-                max=yy_temp[i];
-                i_max_val=i;
+            yy_temp = gr[j]->GetY();
+            max = yy_temp[0];
+            min = yy_temp[0];
+
+            for(int i=0;i<numS;i++) {
+                if(yy_temp[i]>max) {
+                    max=yy_temp[i];
+                    i_max_val=i;
+                }
+                if(yy_temp[i]<min) min=yy_temp[i];
             }
-            if(yy_temp[i]<min) min=yy_temp[i];
-        }
-        for(int i=0;i<numS;i++) {
-            if(i<=i_max_val && yy_temp[i]<=max/2.0) i_left=i;
-            if(i>=i_max_val && yy_temp[i]>=max/2.0) i_right=i;
+            for(int i=0;i<numS;i++) {
+                if(i<=i_max_val && yy_temp[i]<=max/2.0) i_left=i;
+                if(i>=i_max_val && yy_temp[i]>=max/2.0) i_right=i;
+            }
+
+            FitHeight = (max-min)/2;
+            SetFitParameters(ff_left,i_left*dx,FWHM,FitHeight/2,FitHeight);
+            ff_left->SetRange(0,(i_left+i_right)/2.0*dx);
+
+            SetFitParameters(ff_right,i_right*dx,FWHM,FitHeight/2,FitHeight);
+            ff_right->SetRange((i_left+i_right)/2.0*dx,dx*numS);
+
+            gr[j]->Fit("ff_left","Rq");
+            gr[j]->Fit("ff_right","Rq+");
+            gr[j]->GetFunction("ff_right")->SetLineColor(kBlue);
+
+            left_width[j]=ff_left->GetParameter(1)*2.35/TMath::Sqrt(2);
+            left_pos[j]=ff_left->GetParameter(0);
+            right_width[j]=ff_right->GetParameter(1)*2.35/TMath::Sqrt(2);
+            right_pos[j]=ff_right->GetParameter(0);
+
         }
+        delete ff_left;
+        delete ff_right;
+        return;
+    }
 
-        FitHeight = (max-min)/2;
-        SetFitParameters(ff_left,i_left*dx,FWHM,FitHeight/2,FitHeight);
-        ff_left->SetRange(0,(i_left+i_right)/2.0*dx);
+    std::vector<EdgeFit> fits(numP);
 
-        SetFitParameters(ff_right,i_right*dx,FWHM,FitHeight/2,FitHeight);
-        ff_right->SetRange((i_left+i_right)/2.0*dx,dx*numS);
+    if(config->FitContinuation()) {
+        // every fit starts from the previous one
+        FitCount count;
+        for(Int_t j=0;j<numP;j++) FitEdges(gr[j],numS,dx,ff_left,ff_right,fits[j],j>0 ? &fits[j-1] : NULL,&count);
+        PrintFitCount(count,"Edge fits");
+    }
+    else {
+        // the points are taken from the graphs here, the threads only use TCT::Fitter
+        std::vector<Int_t> n(numP);
+        std::vector<Double_t*> x(numP), y(numP);
+        for(Int_t j=0;j<numP;j++) {n[j] = gr[j]->GetN(); x[j] = gr[j]->GetX(); y[j] = gr[j]->GetY();}
+        ErfcEdgeModel left_model;
+        ErfEdgeModel right_model;
+        ParallelFor(numP,[&](Int_t j) {
+            EdgeFit &fit = fits[j];
+            Double_t middle;
+            EdgeStart(y[j],numS,dx,FWHM,fit.par[0],fit.par[1],middle);
+            fit.xmin[0] = 0;
+            fit.xmax[0] = fit.xmin[1] = middle;
+            fit.xmax[1] = dx*numS;
+            for(int k=0;k<2;k++) {
+                Fitter fitter(k==0 ? (const FitModel&)left_model : (const FitModel&)right_model);
+                fit.ok[k] = fitter.Fit(n[j],x[j],y[j],fit.xmin[k],fit.xmax[k],fit.par[k]);
+                for(int i=0;i<4;i++) fit.err[k][i] = fitter.GetErrors()[i];
+                fit.chi2[k] = fitter.GetChisquare();
+                fit.ndf[k] = fitter.GetNDF();
+                fit.npoints[k] = fitter.GetNumberFitPoints();
+            }
+        },(Long64_t)numS*1000);
+    }
 
-        gr[j]->Fit("ff_left","Rq");
-        gr[j]->Fit("ff_right","Rq+");
+    for(Int_t j=0;j<numP;j++) {
+        // store the fitted functions with the graph, as gr->Fit("ff_left","Rq") and gr->Fit("ff_right","Rq+")
+        for(int k=0;k<2;k++) {
+            TF1 *ff = (k==0 ? ff_left : ff_right);
+            ff->SetRange(fits[j].xmin[k],fits[j].xmax[k]);
+            ff->SetParameters(fits[j].par[k]);
+            ff->SetParErrors(fits[j].err[k]);
+            ff->SetChisquare(fits[j].chi2[k]);
+            ff->SetNDF(fits[j].ndf[k]);
+            ff->SetNumberFitPoints(fits[j].npoints[k]);
+            StoreFunction(gr[j],ff,k==1);
+        }
         gr[j]->GetFunction("ff_right")->SetLineColor(kBlue);
 
-        left_width[j]=ff_left->GetParameter(1)*2.35/TMath::Sqrt(2);
-        left_pos[j]=ff_left->GetParameter(0);
-        right_width[j]=ff_right->GetParameter(1)*2.35/TMath::Sqrt(2);
-        right_pos[j]=ff_right->GetParameter(0);
+        left_width[j]=fits[j].par[0][1]*2.35/TMath::Sqrt(2);
+        left_pos[j]=fits[j].par[0][0];
+        right_width[j]=fits[j].par[1][1]*2.35/TMath::Sqrt(2);
+        right_pos[j]=fits[j].par[1][0];
+    }
+
+    delete ff_left;
+    delete ff_right;
+}
+
+/// Start values of the fits of the two edges of one charge profile
+void TCTModule::EdgeStart(const Double_t* y, Int_t numS, Float_t dx, Float_t FWHM, Double_t* left, Double_t* right, Double_t& middle) {
+    /** The edges start at the half maximum points of the profile, the height is half of the
+     *  profile range. middle is the end of the left and the start of the right fit range.
+     */
+    Int_t i_left = 0, i_right = numS-1, i_max_val = 0;
+    Float_t max, min;
+    Float_t FitHeight;
+
+    max = y[0];
+    min = y[0];
 
+    for(int i=0;i<numS;i++) {
+        if(y[i]>max) {
+            max=y[i];
+            i_max_val=i;
+        }
+        if(y[i]<min) min=y[i];
+    }
+    for(int i=0;i<numS;i++) {
+        if(i<=i_max_val && y[i]<=max/2.0) i_left=i;
+        if(i>=i_max_val && y[i]>=max/2.0) i_right=i;
     }
 
+    FitHeight = (max-min)/2;
+    left[0] = i_left*dx; left[1] = FWHM; left[2] = FitHeight/2; left[3] = FitHeight;
+    right[0] = i_right*dx; right[1] = FWHM; right[2] = FitHeight/2; right[3] = FitHeight;
+    middle = (i_left+i_right)/2.0*dx;
+}
+
+/// Fit of the two edges of one charge profile
+void TCTModule::FitEdges(TGraph* gr, Int_t numS, Float_t dx, TF1* ff_left, TF1* ff_right, EdgeFit& fit, const EdgeFit* prev, FitCount* count) {
+    /** The start values are taken from the half maximum points of the profile (see EdgeStart), or from
+     *  the fit of the previous profile prev if it converged (see FitStep), the functions are not stored
+     *  with the graph (see FindEdges).
+     */
+    Double_t left[4], right[4], middle;
+
+    EdgeStart(gr->GetY(),numS,dx,config->FFWHM(),left,right,middle);
+    ff_left->SetParameters(left);
+    ff_left->SetRange(0,middle);
+
+    ff_right->SetParameters(right);
+    ff_right->SetRange(middle,dx*numS);
+
+    fit.ok[0] = FitStep(gr,ff_left,ErfcEdgeModel(),prev && prev->ok[0] ? prev->par[0] : NULL,count);
+    fit.ok[1] = FitStep(gr,ff_right,ErfEdgeModel(),prev && prev->ok[1] ? prev->par[1] : NULL,count);
+
+    for(int k=0;k<2;k++) {
+        TF1 *ff = (k==0 ? ff_left : ff_right);
+        for(int i=0;i<4;i++) {
+            fit.par[k][i] = ff->GetParameter(i);
+            fit.err[k][i] = ff->GetParError(i);
+        }
+        fit.chi2[k] = ff->GetChisquare();
+        fit.ndf[k] = ff->GetNDF();
+        fit.npoints[k] = ff->GetNumberFitPoints();
+        ff->GetRange(fit.xmin[k],fit.xmax[k]);
+    }
+}
+
+/// Fit of a graph with the dedicated fitter
+Bool_t TCTModule::FitGraph(TGraph* gr, TF1* ff, const FitModel& model, Bool_t store, Bool_t plus, Int_t* iterations) {
+    /** Replaces gr->Fit(ff,"Rq") for the models of TCT::Fitter (edges and strips): the start values
+     *  and the range are taken from ff, the results (parameters, errors, chi2, NDF) are written
+     *  back to ff, and if store is set a copy of ff is kept with the graph as by TGraph::Fit.
+     *  \param[in] plus Keep the functions already stored with the graph (option "+")
+     *  \param[out] iterations Number of iterations of the fit
+     *  \return true if the fit converged
+     */
+    Double_t par[Fitter::MaxPar];
+    Double_t xmin, xmax;
+    Fitter fitter(model);
+
+    for(int i=0;i<model.NPar();i++) par[i] = ff->GetParameter(i);
+    ff->GetRange(xmin,xmax);
+    Bool_t ok = fitter.Fit(gr->GetN(),gr->GetX(),gr->GetY(),xmin,xmax,par);
+
+    ff->SetParameters(par);
+    ff->SetParErrors(fitter.GetErrors());
+    ff->SetChisquare(fitter.GetChisquare());
+    ff->SetNDF(fitter.GetNDF());
+    ff->SetNumberFitPoints(fitter.GetNumberFitPoints());
+    if(iterations) *iterations = fitter.GetIterations();
+    if(store) StoreFunction(gr,ff,plus);
+    return ok;
+}
+
+/// One fit of a graph with ROOT or with the dedicated fitter (FastFit)
+Bool_t TCTModule::FitOnce(TGraph* gr, TF1* ff, const FitModel& model, Int_t& calls) {
+    /** The fit starts from the parameters of ff and the results are written to ff, the function
+     *  is not stored with the graph.
+     *  \param[out] calls Iterations (FastFit) or function calls (Minuit) of the fit
+     *  \return true if the fit converged to finite parameters and the first parameter (position) is in the fit range
+     */
+    Bool_t ok;
+    Double_t xmin, xmax;
+    calls = 0;
+    if(config->FastFit()) ok = FitGraph(gr,ff,model,false,false,&calls);
+    else {
+        TFitResultPtr r = gr->Fit(ff,"NRqS");
+        ok = (Int_t)r==0;
+        if(r.Get()) calls = r->NCalls();
+    }
+    ff->GetRange(xmin,xmax);
+    for(int i=0;i<ff->GetNpar();i++) if(!TMath::Finite(ff->GetParameter(i))) ok = false;
+    if(ff->GetParameter(0)<xmin || ff->GetParameter(0)>xmax) ok = false;
+    return ok;
+}
+
+/// Fit of one step of a series (optical positions, voltages) with warm start
+Bool_t TCTModule::FitStep(TGraph* gr, TF1* ff, const FitModel& model, const Double_t* start, FitCount* count) {
+    /** The parameters of ff are the heuristic start values. If start is given (the solution of the
+     *  previous step, FitContinuation), the fit starts from it instead, and if that fit fails it is
+     *  repeated from the heuristic values. The parameter errors are reset before each fit, Minuit
+     *  takes them as step sizes.
+     *  \return true if the fit converged (see FitOnce)
+     */
+    Double_t heuristic[Fitter::MaxPar];
+    Double_t zero[Fitter::MaxPar];
+    Int_t np = ff->GetNpar(), calls;
+    for(int i=0;i<np;i++) {heuristic[i] = ff->GetParameter(i); zero[i] = 0;}
+
+    if(start) {
+        ff->SetParameters(start);
+        ff->SetParErrors(zero);
+        Bool_t ok = FitOnce(gr,ff,model,calls);
+        if(count) {count->warm++; count->warm_calls += calls;}
+        if(ok) return true;
+        if(count) count->fallback++;
+        ff->SetParameters(heuristic);
+    }
+    ff->SetParErrors(zero);
+    Bool_t ok = FitOnce(gr,ff,model,calls);
+    if(count) {count->cold++; count->cold_calls += calls;}
+    return ok;
+}
+
+/// Print the statistics of a series of fits with warm start
+void TCTModule::PrintFitCount(const FitCount& count, const char* title) {
+    const char* unit = config->FastFit() ? "iterations" : "function calls";
+    std::cout<<"\t"<<title<<": "<<count.warm<<" warm starts ("<<count.fallback<<" failed), "<<count.cold<<" from start values"<<std::endl;
+    if(count.warm>0 && count.cold>0) {
+        Double_t warm = (Double_t)count.warm_calls/count.warm;
+        Double_t cold = (Double_t)count.cold_calls/count.cold;
+        std::cout<<"\t"<<title<<": "<<warm<<" "<<unit<<" per warm start, "<<cold<<" from start values ("<<(cold>0 ? 100*(1-warm/cold) : 0)<<"% saved)"<<std::endl;
+    }
+}
+
+/// Keep a copy of the fitted function with the graph
+void TCTModule::StoreFunction(TGraph* gr, TF1* ff, Bool_t plus) {
+    /** The same as TGraph::Fit does with the fitted function: without plus the functions
+     *  stored before are removed.
+     */
+    if(!plus) gr->GetListOfFunctions()->Delete();
+    TF1 *fnew = (TF1*)ff->Clone();
+    fnew->SetParent(gr);
+    fnew->SetBit(TFormula::kNotGlobal);
+    gr->GetListOfFunctions()->Add(fnew);
 }
 
 /// Build graph and return pointer
@@ -395,6 +682,32 @@ Double_t TCTModule::GraphIntegral(TGraph *gr, Double_t x1, Double_t x2) {
     return sum;
 }
 
+/// Run independent tasks on the cores
+void TCTModule::ParallelFor(Int_t n, const std::function<void(Int_t)> &task, Long64_t work) {
+    /** Calls task(j) for j = 0..n-1 on a pool of threads, each thread takes the next free j, so
+     *  tasks of different length are balanced. The tasks must not create, fit or write ROOT objects
+     *  (ROOT 5 is not thread safe): they fill plain arrays, the graphs are built and written
+     *  afterwards in the calling thread, in order.
+     *  \param[in] work Estimated number of operations of one task, 0 - unknown. Less than about
+     *  \f$10^5\f$ operations in all are not worth starting threads and run in the calling thread.
+     */
+    Int_t nth = config->Threads()>1 ? 1 : std::thread::hardware_concurrency();
+    if(work>0 && n*work<100000) nth = 1;
+    if(nth>n) nth = n;
+    if(nth<=1) {
+        for(Int_t j=0;j<n;j++) task(j);
+        return;
+    }
+    std::atomic<Int_t> next(0);
+    auto worker = [&]() {
+        for(Int_t j=next++;j<n;j=next++) task(j);
+    };
+    std::vector<std::thread> pool;
+    for(Int_t t=1;t<nth;t++) pool.push_back(std::thread(worker));
+    worker();
+    for(UInt_t t=0;t<pool.size();t++) pool[t].join();
+}
+
 /// Quick abs implementation
 Double_t TCTModule::abs(Double_t x) {
     if(x<0) return -x;
@@ -8,12 +8,24 @@
 
 
 #include "TCTReader.h"
+#include "TCTSwap.h"
 #include "TMath.h"
 #include "TPaveText.h"
 
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 //ClassImp(TCTReader);
 
-TCTReader::TCTReader(char *FileNameInp, Float_t time0, Int_t Bin)
+TCTReader::TCTReader(char *FileNameInp, Float_t time0, Int_t Bin, Int_t ReadMode, Int_t CacheWFs, std::ostream *out)
 {
     FileName = FileNameInp;
     ////////////////////////////////////////////////////////////////////////////
@@ -25,6 +37,27 @@ TCTReader::TCTReader(char *FileNameInp, Float_t time0, Int_t Bin)
     //          0 - ascii (default) older format has a type 11 while newer has type 22
     //          1 - binary (prefered in new measurements)
     //          2 - binary (little endian)
+    // Int Mode; Selects how the waveforms are kept in memory;
+    //          0 - histograms are filled while reading (default)
+    //          1 - binary file is memory mapped, only the offsets of the waveforms are read.
+    //              Samples are used in place (or byte swapped once on the first access)
+    //              and the histograms are built on request by GetHA.
+    //          2 - samples are read into one contiguous array per channel ([waveform][NP]),
+    //              the histograms are built on request by GetHA.
+    //          3 - lazy reading of binary files, only the offsets of the waveforms are read.
+    //              A waveform is read from the file on the first access and kept among the
+    //              last CacheWFs used ones; baseline and polarity corrections are applied when it is read.
+    //              The open reads only the records of the positions; the polarity vote of CorrectPolarity
+    //              reads the whole file once, when the first waveform of the channel is requested.
+    //          4 - streaming of binary files, one voltage slice (all positions at one U1,U2) is kept in memory.
+    //              The slice is read at once when one of its waveforms is requested and the corrections
+    //              are applied to it, histograms are kept as in Mode=3.
+    //          5 - only the header is read (positions, voltages, time scale, user, sample, comment).
+    //              Currents of binary files are read from the voltage records, no waveforms are available.
+    // Int CacheWFs; number of waveforms kept in memory in Mode=3 (histograms in Mode=4)
+    // std::ostream *out; stream of the progress messages
+    // In Mode=1,2 no ROOT object is made until the first histogram is requested (see MakeHistos), so the
+    // file can be read, corrected and written (WriteBin) on another thread, with out not shared with it.
     // Example of use :
     // // Convert into TCTWaveform along projection
     // TCTReader aa("../Meritve/scanz-grobo-1.tct", 92.2,1); // The second parameter is to set the scale such that signal start at t=0;
@@ -41,12 +74,39 @@ TCTReader::TCTReader(char *FileNameInp, Float_t time0, Int_t Bin)
     histo2 = NULL;
     histo3 = NULL;
     histo4 = NULL;
+    Out = out;
 
     Int_t i,j,Cs,Us,Ss,ofs=0;
     Char_t filef[5];
     float header[200];
     for(i=0;i<4;i++) WFOnOff[i]=0;
+    for(i=0;i<9;i++) xyz[i]=NULL;
+    Mode=ReadMode;
+    Time0=time0;
+    DataStart=0;
+    Map=NULL;
+    MapSize=0;
+    for(i=0;i<4;i++) {Offset[i]=NULL; Store[i]=NULL; Ready[i]=NULL;}
+    CacheSize=(CacheWFs<16)?16:CacheWFs;
+    Cache=NULL;
+    for(i=0;i<4;i++) {Slot[i]=NULL; LazyFlip[i]=0; Cum[i]=NULL;}
+    CumMask=0;
+    SlotCh=SlotWF=SlotPrev=SlotNext=NULL;
+    CacheFirst=CacheLast=-1;
+    CacheUsed=0;
+    LazyBaseLine=0;
+    LazyVote=0;
+    BaseMethod=0;
+    BaseTrim=0.1;
+    BaseTail=-1111;
+    LazyXc=0;
+    SliceBuf=NULL;
+    SliceBytes=0;
+    CurSlice=-1;
     Date=TArrayI(6);
+    type=0;
+    T=0;
+    Source=0;
     User=NULL;
     Comment=NULL;
     Sample=NULL;
@@ -58,6 +118,7 @@ TCTReader::TCTReader(char *FileNameInp, Float_t time0, Int_t Bin)
 
     if(!Bin)  // read ASCII file
     {
+        if(Mode==1 || Mode==3 || Mode==4) {printf("Only binary files can be mapped or read on request, reading the samples\n"); Mode=2;}
         fscanf(in,"%d",&type); // check the file type
         if(!(type==11 || type==22 || type==33 || type==51))  // if it is something else exit
         {
@@ -87,13 +148,12 @@ TCTReader::TCTReader(char *FileNameInp, Float_t time0, Int_t Bin)
             fscanf(in,"%f %f %d\n",&t0,&dt,&NP);
 
             numxyz=Nx*Ny*Nz;
+            if(Mode==5) {fclose(in); in=NULL; RefInd=-1; return;}
 
             for(i=0;i<8;i++) xyz[i]=new Float_t [numxyz*NU1*NU2];
 
-            if(WFOnOff[0]) {histo1 =new TClonesArray("TH1F",numxyz*NU1*NU2); histo1->BypassStreamer(kFALSE);}
-            if(WFOnOff[1]) {histo2 =new TClonesArray("TH1F",numxyz*NU1*NU2); histo2->BypassStreamer(kFALSE);}
-            if(WFOnOff[2]) {histo3 =new TClonesArray("TH1F",numxyz*NU1*NU2); histo3->BypassStreamer(kFALSE);}
-            if(WFOnOff[3]) {histo4 =new TClonesArray("TH1F",numxyz*NU1*NU2); histo4->BypassStreamer(kFALSE);}
+            if(Mode!=2) MakeHistos();
+            if(Mode==2) AllocStore();
         }
         ReadWFs(time0);
     }
@@ -105,7 +165,7 @@ TCTReader::TCTReader(char *FileNameInp, Float_t time0, Int_t Bin)
 
         //get the file type
         type=(Int_t) header[0];
-        std::cout<<"File type = "<<type<<" - reading \n"; // print the file type
+        *Out<<"File type = "<<type<<" - reading \n"; // print the file type
 
         //read in the buffer
         rewind(in);
@@ -168,6 +228,16 @@ TCTReader::TCTReader(char *FileNameInp, Float_t time0, Int_t Bin)
             break;
         }
 
+        DataStart=ftell(in);
+
+        if(Mode==5)
+        {
+            ReadHeaderBin();
+            fclose(in); in=NULL;
+            RefInd=-1;
+            return;
+        }
+
         ////////////////////////////////////////////
         //initializa current arrays
         I2=TArrayF(NU2*NU1);
@@ -175,13 +245,16 @@ TCTReader::TCTReader(char *FileNameInp, Float_t time0, Int_t Bin)
         //number of steps
         numxyz=Nx*Ny*Nz;
         for(i=0;i<9;i++) xyz[i]=new Float_t [numxyz*NU1*NU2];
-        //intitialize histograms
-        if(WFOnOff[0]) {histo1 =new TClonesArray("TH1F",numxyz*NU1*NU2); histo1->BypassStreamer(kFALSE);}
-        if(WFOnOff[1]) {histo2 =new TClonesArray("TH1F",numxyz*NU1*NU2); histo2->BypassStreamer(kFALSE);}
-        if(WFOnOff[2]) {histo3 =new TClonesArray("TH1F",numxyz*NU1*NU2); histo3->BypassStreamer(kFALSE);}
-        if(WFOnOff[3]) {histo4 =new TClonesArray("TH1F",numxyz*NU1*NU2); histo4->BypassStreamer(kFALSE);}
+        //intitialize histograms, in Mode=1,2 only when the first one is requested
+        if(Mode!=1 && Mode!=2) MakeHistos();
         //for(i=0;i<50;i++) printf("%d %f\n",i,header[i]);
-        ReadWFsBin(time0);
+        //in mapped mode the histograms are only created on request
+        if(Mode==1 && !(MapFile() && IndexWFsBin())) {printf("Mapping failed, reading the samples\n"); Mode=2; fseek(in,DataStart,SEEK_SET);}
+        //in lazy mode the waveforms are read when they are requested
+        if((Mode==3 || Mode==4) && !IndexWFsBin()) {printf("Indexing failed, reading the samples\n"); Mode=2; fseek(in,DataStart,SEEK_SET);}
+        if(Mode==3 || Mode==4) AllocCache();
+        if(Mode==2) AllocStore();
+        if(Mode==0 || Mode==2) ReadWFsBin(time0);
 
     }
 
@@ -207,10 +280,290 @@ TCTReader::~TCTReader()
         delete histo4;
         histo4 = NULL;
     }
-    delete User;
-    delete Sample;
-    delete Comment;
+    delete [] User;
+    delete [] Sample;
+    delete [] Comment;
     for(int i=0;i<9;i++) delete xyz[i];
+    for(int i=0;i<4;i++) {
+        delete [] Offset[i];
+        delete [] Store[i];
+        delete [] Ready[i];
+        delete [] Slot[i];
+        delete [] Cum[i];
+    }
+    ClearProducts();
+    if(Cache) delete Cache;
+    delete [] SliceBuf;
+    delete [] SlotCh;
+    delete [] SlotWF;
+    delete [] SlotPrev;
+    delete [] SlotNext;
+#ifndef _WIN32
+    if(Map) munmap(Map,MapSize);
+#endif
+    if(in) fclose(in);
+}
+
+Bool_t TCTReader::MapFile()
+{
+    // Maps the input file into the memory (Mode=1)
+    // The mapping is private, so corrections of the samples never reach the file on disk.
+#ifndef _WIN32
+    struct stat st;
+    if(fstat(fileno(in),&st)!=0) return kFALSE;
+    void *addr=mmap(NULL,st.st_size,PROT_READ|PROT_WRITE,MAP_PRIVATE,fileno(in),0);
+    if(addr==MAP_FAILED) return kFALSE;
+    Map=(Char_t *)addr;
+    MapSize=st.st_size;
+    return kTRUE;
+#else
+    return kFALSE;
+#endif
+}
+
+void TCTReader::AllocStore()
+{
+    // Allocates the contiguous sample arrays of the switched on channels (Mode=2)
+    Int_t Num=numxyz*NU1*NU2;
+    for(Int_t k=0;k<4;k++)
+        if(WFOnOff[k]==1) Store[k]=new Float_t[(Long64_t)Num*NP];
+}
+
+void TCTReader::AllocCache()
+{
+    // Allocates the cache of the waveforms read on request (Mode=3)
+    Int_t Num=numxyz*NU1*NU2;
+    Cache=new TClonesArray("TH1F",CacheSize);
+    Cache->BypassStreamer(kFALSE);
+    for(Int_t k=0;k<4;k++)
+    {
+        if(WFOnOff[k]!=1) continue;
+        Slot[k]=new Int_t[Num];
+        for(Int_t i=0;i<Num;i++) Slot[k][i]=-1;
+    }
+    SlotCh=new Int_t[CacheSize];
+    SlotWF=new Int_t[CacheSize];
+    SlotPrev=new Int_t[CacheSize];
+    SlotNext=new Int_t[CacheSize];
+    for(Int_t i=0;i<CacheSize;i++) SlotPrev[i]=SlotNext[i]=-1;
+}
+
+void TCTReader::ResetCache()
+{
+    // Forgets all waveforms in the cache (Mode=3), they are read again with the current corrections
+    for(Int_t s=0;s<CacheUsed;s++)
+    {
+        Slot[SlotCh[s]][SlotWF[s]]=-1;
+        SlotPrev[s]=SlotNext[s]=-1;
+    }
+    CacheUsed=0;
+    CacheFirst=CacheLast=-1;
+    CurSlice=-1;
+}
+
+void TCTReader::LazyCorrect(Int_t ch, Float_t *wf)
+{
+    // Applies the corrections requested by CorrectBaseLine and CorrectPolarity to the waveform just read (Mode=3,4)
+    Int_t i;
+    Double_t corr,slope;
+    if(LazyBaseLine&(1<<ch))
+    {
+        corr=BaseLine(wf,TimeBin(LazyXc),slope);
+        for(i=0;i<NP-1;i++) wf[i]=wf[i]-(corr+slope*i);
+    }
+    if(LazyFlip[ch]) for(i=0;i<NP-1;i++) wf[i]=-wf[i];
+}
+
+Float_t *TCTReader::SliceWF(Int_t ch, Int_t ii)
+{
+    // Function returns the samples of the waveform from the voltage slice in memory (Mode=4)
+    // The slice holding the waveform replaces the previous one if needed.
+    Int_t i,k,sl=ii/numxyz;
+    Long64_t start=DataStart+(Long64_t)sl*SliceBytes;
+    Float_t *wf;
+
+    if(sl!=CurSlice)
+    {
+        if(SliceBuf==NULL) SliceBuf=new Float_t[SliceBytes/sizeof(Float_t)];
+        if(!ReadAt(start,SliceBuf,SliceBytes)) printf("Error reading voltage slice %d\n",sl);
+        for(i=sl*numxyz;i<(sl+1)*numxyz;i++)
+            for(k=0;k<4;k++)
+            {
+                if(WFOnOff[k]!=1) continue;
+                wf=SliceBuf+(Offset[k][i]-start)/sizeof(Float_t);
+                if(BLE_CODE) swooip(wf,NP);
+                LazyCorrect(k,wf);
+            }
+        CurSlice=sl;
+    }
+    return SliceBuf+(Offset[ch][ii]-start)/sizeof(Float_t);
+}
+
+Bool_t TCTReader::ReadAt(Long64_t pos, void *buf, Long64_t size)
+{
+    // Reads size bytes at the position pos of the input file (from the map if it exists).
+    // A voltage slice can be larger than 2 GB, the file is read in pieces of at most 1 GB.
+    if(Map) {memcpy(buf,Map+pos,(size_t)size); return kTRUE;}
+    if(fseek(in,pos,SEEK_SET)!=0) return kFALSE;
+    Char_t *p=(Char_t *)buf;
+    while(size>0)
+    {
+        size_t n=size>(1<<30) ? (size_t)(1<<30) : (size_t)size;
+        if(fread(p,1,n,in)!=n) return kFALSE;
+        p+=n; size-=n;
+    }
+    return kTRUE;
+}
+
+Int_t TCTReader::Decode(Int_t ch, Int_t ii)
+{
+    // Function returns the cache slot holding the waveform and reads it from the file (Mode=3)
+    // or from the voltage slice (Mode=4) if needed.
+    // The least recently used waveform is dropped when the cache is full.
+    // The first waveform of a channel waiting for its polarity vote reads the whole file for the vote (Mode=3).
+    Char_t hisname[100];
+    Int_t s=Slot[ch][ii];
+    Float_t *wf;
+    TH1F *his;
+
+    if(s<0)
+    {
+        if(LazyVote&(1<<ch))
+        {
+            // polarity requested by CorrectPolarity, no waveform of the channel is in the cache yet
+            LazyVote&=~(1<<ch);
+            if(PolarityVote(ch)<0)
+            {
+                LazyFlip[ch]=!LazyFlip[ch];
+                *Out<<"Polarity correction ("<<numxyz*NU1*NU2<<" waveforms) :: applied on reading\n";
+            }
+            else *Out<<"Polarity correction not needed\n";
+        }
+        if(CacheUsed<CacheSize) s=CacheUsed++;
+        else {s=CacheLast; Slot[SlotCh[s]][SlotWF[s]]=-1;}
+        SlotCh[s]=ch; SlotWF[s]=ii; Slot[ch][ii]=s;
+
+        sprintf(hisname,"Ch. %d:x=%.6e,y=%.6e,z=%.6e,U1=%4.2f, U2=%4.2f ",ch+1,xyz[0][ii],xyz[1][ii],xyz[2][ii],xyz[3][ii],xyz[4][ii]);
+        his=(TH1F *)Cache->At(s);
+        if(his==NULL)
+        {
+            TClonesArray &entryp = *Cache;
+            his=new(entryp[s]) TH1F((const Char_t *)(hisname),(const Char_t *)(hisname),NP,t0*1e9-Time0,(NP*dt+t0)*1e9-Time0);
+        }
+        else his->SetNameTitle((const Char_t *)(hisname),(const Char_t *)(hisname));
+
+        wf=his->GetArray()+1;
+        if(Mode==4) memcpy(wf,SliceWF(ch,ii),NP*sizeof(Float_t));
+        else
+        {
+            if(!ReadAt(Offset[ch][ii],wf,NP*sizeof(Float_t))) printf("Error reading waveform %d of channel %d\n",ii,ch+1);
+            if(BLE_CODE) swooip(wf,NP);
+            LazyCorrect(ch,wf);
+        }
+        his->SetEntries(NP);
+    }
+
+    if(s!=CacheFirst)
+    {
+        // move the slot to the front of the list
+        if(SlotPrev[s]>=0) SlotNext[SlotPrev[s]]=SlotNext[s];
+        if(SlotNext[s]>=0) SlotPrev[SlotNext[s]]=SlotPrev[s];
+        if(CacheLast==s) CacheLast=SlotPrev[s];
+        SlotPrev[s]=-1; SlotNext[s]=CacheFirst;
+        if(CacheFirst>=0) SlotPrev[CacheFirst]=s;
+        CacheFirst=s;
+        if(CacheLast<0) CacheLast=s;
+    }
+    return s;
+}
+
+void TCTReader::ReadHeaderBin()
+{
+    // Reads the voltages and currents of the binary file without its waveforms (Mode=5)
+    // Only the record at the start of every voltage slice is read, the slices are skipped.
+    Int_t k,q,r,nch=0;
+    Int_t ncord=(type==51)?5:4;
+    Float_t buf[4];
+    numxyz=Nx*Ny*Nz;
+    I2=TArrayF(NU2*NU1);
+    I1=TArrayF(NU2*NU1);
+    for(k=0;k<4;k++) if(WFOnOff[k]==1) nch++;
+    SliceBytes=(4+numxyz*(ncord+nch*(Long64_t)NP))*sizeof(Float_t);
+    for(q=0;q<NU1;q++)
+        for(r=0;r<NU2;r++)
+        {
+            if(!ReadAt(DataStart+(Long64_t)(r+q*NU2)*SliceBytes,buf,4*sizeof(Float_t))) return;
+            if(BLE_CODE) swooip(buf,4);
+            U1[q]=buf[0]; I1[r+q*NU2]=buf[2];
+            U2[r]=buf[1]; I2[r+q*NU2]=buf[3];
+        }
+}
+
+Bool_t TCTReader::IndexWFsBin()
+{
+    // Indexes the binary waveforms in the mapped (Mode=1) or opened (Mode=3,4) file
+    // Only the voltage and position records are decoded, the positions of the samples are stored in Offset.
+    // Samples of little endian files, aligned in the file, are used in place, the rest is
+    // byte swapped into Store on the first access (Mode=1).
+    Int_t i,ii,j,k,q,r;
+    Float_t buf[5];
+    Int_t ncord=(type==51)?5:4;
+    Int_t Num=numxyz*NU1*NU2;
+    Int_t nch=0;
+    Long64_t pos=DataStart;
+    Long64_t wfsize=(Long64_t)NP*sizeof(Float_t);
+    Long64_t size=MapSize;
+
+    if(Map==NULL) {fseek(in,0,SEEK_END); size=ftell(in);}
+    for(k=0;k<4;k++) if(WFOnOff[k]==1) nch++;
+    SliceBytes=(4+numxyz*(ncord+nch*(Long64_t)NP))*sizeof(Float_t);
+    if(DataStart+(Long64_t)NU1*NU2*(4+numxyz*(ncord+nch*(Long64_t)NP))*sizeof(Float_t)>size)
+    {
+        printf("File is shorter than the header describes\n");
+        return kFALSE;
+    }
+
+    for(k=0;k<4;k++)
+    {
+        if(WFOnOff[k]!=1) continue;
+        Offset[k]=new Long64_t[Num];
+        if(Mode==1 && (BLE_CODE || DataStart%sizeof(Float_t)))
+        {
+            // allocated pages are touched only by the decoded waveforms
+            Store[k]=new Float_t[(Long64_t)Num*NP];
+            Ready[k]=new Char_t[Num];
+            memset(Ready[k],0,Num);
+        }
+    }
+
+    for(q=0;q<NU1;q++)
+    {
+        for(r=0;r<NU2;r++)
+        {
+            ReadAt(pos,buf,4*sizeof(Float_t)); pos+=4*sizeof(Float_t);
+            if(BLE_CODE) swooip(buf,4);
+            U1[q]=buf[0]; I1[r+q*NU2]=buf[2];
+            U2[r]=buf[1]; I2[r+q*NU2]=buf[3];
+
+            for(i=0;i<numxyz;i++)
+            {
+                ii=i+numxyz*r+(NU2*numxyz)*q;
+                ReadAt(pos,buf,ncord*sizeof(Float_t)); pos+=ncord*sizeof(Float_t);
+                if(BLE_CODE) swooip(buf,ncord);
+                for(j=0;j<3;j++) xyz[j][ii]=buf[j];
+                xyz[7][ii]=buf[3];
+                if(type==51) xyz[8][ii]=buf[4];
+                xyz[3][ii]=U1[q]; xyz[4][ii]=U2[r];
+                xyz[5][ii]=I1[r+q*NU2]; xyz[6][ii]=I2[r+q*NU2];
+
+                for(k=0;k<4;k++)
+                {
+                    if(WFOnOff[k]==1) {Offset[k][ii]=pos; pos+=wfsize;}
+                }
+            }
+        }
+    }
+    return kTRUE;
 }
 
 void  TCTReader::ReadWFsBin(Float_t time0)
@@ -261,25 +614,25 @@ void  TCTReader::ReadWFsBin(Float_t time0)
                 xyz[5][ii]=tI1; xyz[6][ii]=tI2;
 
 
-                if(WFOnOff[0])
+                if(WFOnOff[0] && Mode==0)
                 {
                     sprintf(hisname1,"Ch. 1:x=%.6e,y=%.6e,z=%.6e,U1=%4.2f, U2=%4.2f ",xyz[0][ii],xyz[1][ii],xyz[2][ii],xyz[3][ii],xyz[4][ii]);
                     new(entryp1[ii]) TH1F((const Char_t *)(hisname1),(const Char_t *)(hisname1),NP,t0*1e9-time0,(NP*dt+t0)*1e9-time0);
                 }
 
-                if(WFOnOff[1])
+                if(WFOnOff[1] && Mode==0)
                 {
                     sprintf(hisname2,"Ch. 2:x=%.6e,y=%.6e,z=%.6e,U1=%4.2f, U2=%4.2f ",xyz[0][ii],xyz[1][ii],xyz[2][ii],xyz[3][ii],xyz[4][ii]);
                     new(entryp2[ii]) TH1F((const Char_t *)(hisname2),(const Char_t *)(hisname2),NP,t0*1e9-time0,(NP*dt+t0)*1e9-time0);
                 }
 
-                if(WFOnOff[2])
+                if(WFOnOff[2] && Mode==0)
                 {
                     sprintf(hisname3,"Ch. 3:x=%.6e,y=%.6e,z=%.6e,U1=%4.2f, U2=%4.2f ",xyz[0][ii],xyz[1][ii],xyz[2][ii],xyz[3][ii],xyz[4][ii]);
                     new(entryp3[ii]) TH1F((const Char_t *)(hisname3),(const Char_t *)(hisname3),NP,t0*1e9-time0,(NP*dt+t0)*1e9-time0);
                 }
 
-                if(WFOnOff[3])
+                if(WFOnOff[3] && Mode==0)
                 {
                     sprintf(hisname4,"Ch. 4:x=%.6e,y=%.6e,z=%.6e,U1=%4.2f, U2=%4.2f ",xyz[0][ii],xyz[1][ii],xyz[2][ii],xyz[3][ii],xyz[4][ii]);
                     new(entryp4[ii]) TH1F((const Char_t *)(hisname4),(const Char_t *)(hisname4),NP,t0*1e9-time0,(NP*dt+t0)*1e9-time0);
@@ -291,6 +644,12 @@ void  TCTReader::ReadWFsBin(Float_t time0)
                     if(WFOnOff[k]==1)
                     {
                         //	printf("reading ...... %d %d ... ",k,ftell(in));
+                        if(Mode==2)
+                        {
+                            // samples go straight into the store, no histogram is made
+                            fread(Store[k]+(Long64_t)ii*NP,sizeof(Float_t),NP,in); if(BLE_CODE) swooip(Store[k]+(Long64_t)ii*NP, NP);
+                            continue;
+                        }
                         numread=fread(buf,sizeof(Float_t),NP,in);  if(BLE_CODE) swooip(buf, NP); // printf("%f %f %f\n",buf[NP-3],buf[NP-2],buf[NP-1]);
                         //	printf("read ...... %d(%d)\n",numread,ii);  if(ii==17) return;
                         //fread(buf,sizeof(Float_t),NP,in);  swooip(buf, NP);
@@ -333,10 +692,75 @@ void  TCTReader::ReadWFsBin(Float_t time0)
 
 
 
+static Long64_t ParseTokens(char *b, char *e, Float_t *out)
+{
+    // Converts the whitespace separated numbers in [b,e) and returns their number
+    // Float_t *out; array for the numbers, if NULL they are only counted
+    // Every token gives one number (0 if it can not be converted), e must point to a whitespace.
+    Long64_t n=0;
+    char *end;
+    while(b<e)
+    {
+        while(b<e && isspace((unsigned char)*b)) b++;
+        if(b>=e) break;
+        if(out)
+        {
+            out[n]=strtof(b,&end);
+            if(end==b) out[n]=0;
+            if(end>b) b=end;
+        }
+        while(b<e && !isspace((unsigned char)*b)) b++;
+        n++;
+    }
+    return n;
+}
+
+Long64_t TCTReader::ParseWFs(std::vector<Float_t> &val)
+{
+    // Reads the rest of the ASCII file and converts all numbers into val
+    // The text is split at whitespaces into one chunk per thread, the numbers in the
+    // chunks are counted and then converted in parallel to their place in val.
+    Long64_t i,n,start=ftell(in);
+    fseek(in,0,SEEK_END);
+    n=ftell(in)-start;
+    fseek(in,start,SEEK_SET);
+    std::vector<char> text(n+1);
+    n=fread(&text[0],1,n,in);
+    text[n]='\0';
+
+    Int_t nth=std::thread::hardware_concurrency();
+    if(nth<1) nth=1;
+    if(n<(1<<20)) nth=1;
+    std::vector<char *> cut(nth+1);
+    std::vector<Long64_t> first(nth+1,0);
+    std::vector<std::thread> pool;
+    cut[0]=&text[0]; cut[nth]=&text[0]+n;
+    for(i=1;i<nth;i++)
+    {
+        cut[i]=&text[0]+n*i/nth;
+        while(cut[i]<cut[nth] && !isspace((unsigned char)*cut[i])) cut[i]++;
+    }
+
+    for(i=0;i<nth;i++) pool.push_back(std::thread([&,i]() {first[i+1]=ParseTokens(cut[i],cut[i+1],NULL);}));
+    for(i=0;i<nth;i++) pool[i].join();
+    for(i=0;i<nth;i++) first[i+1]+=first[i];
+
+    val.resize(first[nth]);
+    pool.clear();
+    for(i=0;i<nth;i++) pool.push_back(std::thread([&,i]() {ParseTokens(cut[i],cut[i+1],val.data()+first[i]);}));
+    for(i=0;i<nth;i++) pool[i].join();
+    return first[nth];
+}
+
 void  TCTReader::ReadWFs(Float_t time0)
 {
+    // read in ASCII waveforms
+    // All numbers are converted at once (see ParseWFs), then the waveforms are filled in the order of the file.
     Int_t i,ii,j,k,q,r;
     Float_t data,tU1,tU2,tI1,tI2;
+    std::vector<Float_t> val;
+    Long64_t p=0,ntok=ParseWFs(val);
+    auto next=[&](Float_t &x) {if(p<ntok) x=val[p++];};
     Char_t hisname1[100];
     Char_t hisname2[100];
     Char_t hisname3[100];
@@ -354,7 +778,7 @@ void  TCTReader::ReadWFs(Float_t time0)
 
             if(type!=11)
             {
-                fscanf(in,"%f %f %f %f",&tU1,&tU2,&tI1,&tI2);
+                next(tU1); next(tU2); next(tI1); next(tI2);
                 // printf("%d %d :: %f %f %f %f\n",r,q,tU1,tU2,tI1,tI2);
                 U1[q]=tU1; I1[r+q*NU2]=tI1;
                 U2[r]=tU2; I2[r+q*NU2]=tI2;
@@ -368,28 +792,28 @@ void  TCTReader::ReadWFs(Float_t time0)
 
                 if(type==22 || type==33)
                 {
-                    for(j=0;j<4;j++) fscanf(in,"%f",&xyz[j][ii]); xyz[7][ii]=xyz[3][ii];
+                    for(j=0;j<4;j++) next(xyz[j][ii]); xyz[7][ii]=xyz[3][ii];
                     xyz[3][ii]=tU1; xyz[4][ii]=tU2; xyz[5][ii]=tI1; xyz[6][ii]=tI2;
                 }
-                if(type==11) for(j=0;j<5;j++) fscanf(in,"%f",&xyz[j][ii]);
+                if(type==11) for(j=0;j<5;j++) next(xyz[j][ii]);
 
-                if(WFOnOff[0])
+                if(WFOnOff[0] && Mode==0)
                 {
                     sprintf(hisname1,"Ch. 1:x=%.6e,y=%.6e,z=%.6e,U1=%4.2f, U2=%4.2f ",xyz[0][ii],xyz[1][ii],xyz[2][ii],xyz[3][ii],xyz[4][ii]);
                     new(entryp1[ii]) TH1F((const Char_t *)(hisname1),(const Char_t *)(hisname1),NP,t0*1e9-time0,(NP*dt+t0)*1e9-time0);
                 }
-                if(WFOnOff[1])
+                if(WFOnOff[1] && Mode==0)
                 {
                     sprintf(hisname2,"Ch. 2:x=%.6e,y=%.6e,z=%.6e,U1=%4.2f, U2=%4.2f ",xyz[0][ii],xyz[1][ii],xyz[2][ii],xyz[3][ii],xyz[4][ii]);
                     new(entryp2[ii]) TH1F((const Char_t *)(hisname2),(const Char_t *)(hisname2),NP,t0*1e9-time0,(NP*dt+t0)*1e9-time0);
                 }
-                if(WFOnOff[2])
+                if(WFOnOff[2] && Mode==0)
                 {
                     sprintf(hisname3,"Ch. 3:x=%.6e,y=%.6e,z=%.6e,U1=%4.2f, U2=%4.2f ",xyz[0][ii],xyz[1][ii],xyz[2][ii],xyz[3][ii],xyz[4][ii]);
                     new(entryp3[ii]) TH1F((const Char_t *)(hisname3),(const Char_t *)(hisname3),NP,t0*1e9-time0,(NP*dt+t0)*1e9-time0);
                 }
 
-                if(WFOnOff[3])
+                if(WFOnOff[3] && Mode==0)
                 {
                     sprintf(hisname4,"Ch. 4:x=%.6e,y=%.6e,z=%.6e,U1=%4.2f, U2=%4.2f ",xyz[0][ii],xyz[1][ii],xyz[2][ii],xyz[3][ii],xyz[4][ii]);
                     new(entryp4[ii]) TH1F((const Char_t *)(hisname4),(const Char_t *)(hisname4),NP,t0*1e9-time0,(NP*dt+t0)*1e9-time0);
@@ -402,7 +826,8 @@ void  TCTReader::ReadWFs(Float_t time0)
                     {
                         for(j=0;j<NP;j++)
                         {
-                            fscanf(in,"%e",&data); //printf("%e ",data);
+                            next(data); //printf("%e ",data);
+                            if(Mode==2) {Store[k][(Long64_t)ii*NP+j]=data; continue;}
                             switch(k)
                             {
                             case 0:
@@ -426,28 +851,25 @@ void  TCTReader::ReadWFs(Float_t time0)
             }
         }
     }
+    if(p<ntok) printf("%lld numbers at the end of the file were not used\n",ntok-p);
     //fclose(in);
 }
 
 TH1F *TCTReader::GetHA(int ch , int index)
 {
+    // In Mode=3,4 the histogram is reused once CacheWFs other waveforms were requested.
     TH1F *his;
+    if(!HasChannel(ch)) return NULL;
+    MakeHistos();
+    if(Mode==3 || Mode==4) his=(TH1F *)Cache->At(Decode(ch,index));
+    else his=(TH1F *)Histos(ch)->At(index);
+    if(his==NULL) his=NewHisto(ch,index);
     switch(ch)
     {
-    case 0:
-        his=(TH1F *)histo1->At(index);
-        his->SetLineColor(1);
-        break;
-    case 1: his=(TH1F *)histo2->At(index);
-        his->SetLineColor(2);
-        break;
-    case 2: his=(TH1F *)histo3->At(index);
-        his->SetLineColor(4);
-        break;
-    case 3: his=(TH1F *)histo4->At(index);
-        his->SetLineColor(5);
-        break;
-    default: his=NULL; break;
+    case 0: his->SetLineColor(1); break;
+    case 1: his->SetLineColor(2); break;
+    case 2: his->SetLineColor(4); break;
+    case 3: his->SetLineColor(5); break;
     }
     his->GetXaxis()->SetTitle("t [ns]");
     his->GetYaxis()->SetTitle("I [arb.]");
@@ -455,6 +877,95 @@ TH1F *TCTReader::GetHA(int ch , int index)
     return(his);
 }
 
+void TCTReader::MakeHistos()
+{
+    // Creates the arrays of the histograms of the channels which are on, if they do not exist yet
+    // In Mode=1,2 it is called when the first histogram is requested, the samples are kept outside of them.
+    Int_t k;
+    TClonesArray **h[4]={&histo1,&histo2,&histo3,&histo4};
+    for(k=0;k<4;k++)
+        if(WFOnOff[k] && *h[k]==NULL)
+        {
+            *h[k]=new TClonesArray("TH1F",numxyz*NU1*NU2);
+            (*h[k])->BypassStreamer(kFALSE);
+        }
+}
+
+TClonesArray *TCTReader::Histos(Int_t ch)
+{
+    // Function returns the array of histograms of the channel
+    switch(ch)
+    {
+    case 0: return histo1;
+    case 1: return histo2;
+    case 2: return histo3;
+    case 3: return histo4;
+    default: return NULL;
+    }
+}
+
+Float_t *TCTReader::Samples(Int_t ch, Int_t index)
+{
+    // Function returns the samples of the waveform kept outside of the histograms (Mode=1,2)
+    Float_t *wf;
+    if(Store[ch]==NULL) return (Offset[ch]!=NULL) ? (Float_t *)(Map+Offset[ch][index]) : NULL;
+    wf=Store[ch]+(Long64_t)index*NP;
+    if(Ready[ch]!=NULL && !Ready[ch][index])
+    {
+        memcpy(wf,Map+Offset[ch][index],NP*sizeof(Float_t));
+        if(BLE_CODE) swooip(wf,NP);
+        Ready[ch][index]=1;
+    }
+    return wf;
+}
+
+TH1F *TCTReader::NewHisto(Int_t ch, Int_t ii)
+{
+    // Function builds the histogram of the waveform from the samples kept in memory
+    Char_t hisname[100];
+    MakeHistos();
+    TClonesArray &entryp = *Histos(ch);
+    Float_t *wf=Samples(ch,ii);
+
+    sprintf(hisname,"Ch. %d:x=%.6e,y=%.6e,z=%.6e,U1=%4.2f, U2=%4.2f ",ch+1,xyz[0][ii],xyz[1][ii],xyz[2][ii],xyz[3][ii],xyz[4][ii]);
+    TH1F *his=new(entryp[ii]) TH1F((const Char_t *)(hisname),(const Char_t *)(hisname),NP,t0*1e9-Time0,(NP*dt+t0)*1e9-Time0);
+    if(wf!=NULL)
+    {
+        memcpy(his->GetArray()+1,wf,NP*sizeof(Float_t));
+        his->SetEntries(NP);
+    }
+    return his;
+}
+
+Float_t *TCTReader::GetWF(Int_t ch, Int_t index)
+{
+    // Function returns the pointer to the NP samples of the waveform (bins 1..NP of its histogram)
+    // Int_t ch; channel number
+    // Int_t index; index of the waveform (see indx)
+    // If the histogram was already built the samples are shared with it.
+    // In Mode=3 the samples stay valid until CacheWFs other waveforms are requested,
+    // in Mode=4 until a waveform of another voltage slice is requested.
+    TClonesArray *h=Histos(ch);
+    if(!HasChannel(ch)) return NULL;
+    if(Mode==3) return ((TH1F *)Cache->At(Decode(ch,index)))->GetArray()+1;
+    if(Mode==4) return SliceWF(ch,index);
+    TH1F *his=(h!=NULL) ? (TH1F *)h->At(index) : NULL;
+    if(his!=NULL) return his->GetArray()+1;
+    Float_t *wf=Samples(ch,index);
+    if(wf==NULL) wf=NewHisto(ch,index)->GetArray()+1;
+    return wf;
+}
+
+Int_t TCTReader::TimeBin(Float_t t)
+{
+    // Function returns the bin of the waveform histograms at time t (same as TAxis::FindBin)
+    Double_t low=t0*1e9-Time0;
+    Double_t high=(NP*dt+t0)*1e9-Time0;
+    if(t<low) return 0;
+    if(!(t<high)) return NP+1;
+    return 1+(Int_t)(NP*(t-low)/(high-low));
+}
+
 TH1F *TCTReader::GetHA(Int_t ch , Int_t x, Int_t y, Int_t z, Int_t nu1, Int_t nu2)
 {
     return(GetHA(ch,indx(x,y,z,nu1,nu2)));
@@ -774,6 +1285,7 @@ TCTWaveform *TCTReader::Projection(int ch, int dir,int x,int y,int z, int nu1, i
 
     Float_t Delta;
     Int_t i=0,ix;
+    Int_t *List=new Int_t[num];
     TCTWaveform *MWF=new TCTWaveform(num);
     TH1F *his;
     for(i=0;i<num;i++)
@@ -789,12 +1301,35 @@ TCTWaveform *TCTReader::Projection(int ch, int dir,int x,int y,int z, int nu1, i
         }
         his=GetHA(ch,ix);
         MWF->AddHisto(i,Delta,his);
+        List[i]=ix;
     }
+    MWF->SetSource(this,ch,List);
+    delete [] List;
     MWF->DrawMode=false;
     //    strcpy(MWF->suffix," #mum");
     return MWF;
 }
 
+TCTView TCTReader::View(Int_t ch, Int_t dir, Int_t x, Int_t y, Int_t z, Int_t nu1, Int_t nu2, Int_t num)
+{
+    // Function returns the projection of the waveforms as Projection, but without copying them
+    // The parameters are the same as in Projection. The view holds no memory, its waveforms are
+    // taken from the reader by GetWF/GetHA and their integrals by Integral, e.g.
+    // TCTView v=aa.View(0,0,0,0,0,0,0,aa.Nx); for(i=0;i<v.GetN();i++) q=v.Integral(i,2,10);
+    Int_t stride,start=0,n;
+    switch(dir)
+    {
+    case 1: stride=Nx; n=Ny-y; break;
+    case 2: stride=Nx*Ny; n=Nz-z; break;
+    case 3: stride=NU2*numxyz; n=NU1-nu1; start=nu1; break;
+    case 4: stride=numxyz; n=NU2-nu2; start=nu2; break;
+    default: dir=0; stride=1; n=Nx-x; break;
+    }
+    if(num>n) {printf("View: only %d waveforms along the direction %d\n",n,dir); num=n;}
+    if(num<0) num=0;
+    return TCTView(this,ch,dir,indx(x,y,z,nu1,nu2),stride,start,num);
+}
+
 void TCTReader::DrawList(Int_t num, Int_t *List)
 {
     Float_t Delta;
@@ -827,103 +1362,558 @@ void TCTReader::CorrectBaseLine(Float_t xc)
     // Function corrects the baseline (DC offset) of all wafeforms
     // Float_t xc ; time denoting the start of the pulse
     //              correction factor is calculated from all the bins before xc
-    Int_t right[4],left[4];
+    // In Mode=3,4 the correction is applied to every waveform when it is read.
+    Int_t right;
     Int_t i,j,k;
-    Double_t sum=0,corr[4];
-    TH1F *his[4];
+    Double_t corr[4],slope[4];
+    Float_t *wf[4];
     Int_t Num=numxyz*NU1*NU2; //number of all waveforms
 
+    ClearProducts();
+    if(Mode==3 || Mode==4)
+    {
+        LazyBaseLine=7;
+        LazyXc=xc;
+        ResetCache();
+        *Out<<"Baseline correction ("<<Num<<" waveforms) :: applied on reading\n";
+        return;
+    }
+
+    right=TimeBin(xc);
 
     for(j=0;j<Num;j++)
     {
-        if(j==0)  std::cout<<"Baseline correction ("<<Num<<" waveforms) :: ";
-
-        if(WFOnOff[0]==1) his[0]=((TH1F *)histo1->At(j));
-        if(WFOnOff[1]==1) his[1]=((TH1F *)histo2->At(j));
-        if(WFOnOff[2]==1) his[2]=((TH1F *)histo3->At(j));
-        if(WFOnOff[3]==1) his[3]=((TH1F *)histo4->At(j));
+        if(j==0)  *Out<<"Baseline correction ("<<Num<<" waveforms) :: ";
 
         for(i=0;i<4;i++)
         {
             if(WFOnOff[i]==1)
             {
-                right[i]=his[i]->GetXaxis()->FindBin(xc);
-                left[i]=1;
-                his[i]->Integral(left[i],right[i]);
-                corr[i]=his[i]->Integral(left[i],right[i])/(right[i]-left[i]);
+                wf[i]=GetWF(i,j);
+                corr[i]=BaseLine(wf[i],right,slope[i]);
             }
         }
 
-        if(j%100==0) std::cout<<".";
+        if(j%100==0) *Out<<".";
         //printf("%d :: Baseline correction = %e , Integral before trigger=%e , Nbins=%d!\n",j,corr,his->Integral(left,right),right-left);
 
         for(k=0;k<3;k++)
             if(WFOnOff[k]==1)
-                for(i=1;i<his[k]->GetNbinsX();i++)
-                    his[k]->SetBinContent(i,his[k]->GetBinContent(i)-corr[k]);
+                for(i=0;i<NP-1;i++)
+                    wf[k][i]=wf[k][i]-(corr[k]+slope[k]*i);
 
     }
 
-    std::cout<<" finished\n";
+    *Out<<" finished\n";
 
 }
 
+void TCTReader::SetBaseLine(Int_t method, Float_t trim, Float_t tail)
+{
+    // Selects the estimator of the baseline used by CorrectBaseLine and Preprocess
+    // Int_t method; 0 - mean of the bins before the pulse start (default)
+    //               1 - median of the bins before the pulse start
+    //               2 - trimmed mean, the lowest and highest fraction trim of the bins are not used
+    //               3 - straight line fitted to the bins before the pulse start and after the time tail,
+    //                   corrects a drift of the baseline
+    // Float_t tail; start of the tail window (same time scale as the pulse start), no tail window if -1111
+    BaseMethod=method;
+    BaseTrim=(trim<0)?0:(trim>0.49)?0.49:trim;
+    BaseTail=tail;
+}
+
+Double_t TCTReader::BaseLine(Float_t *wf, Int_t right, Double_t &slope)
+{
+    // Function returns the baseline of the waveform at its first sample
+    // same bins as the histogram integral from the first bin to the bin right (bin of the pulse start)
+    // Double_t &slope; change of the baseline per sample, 0 unless the linear baseline is used
+    // Median and trimmed mean partially sort a copy of the bins (O(n)), the line is fitted in one pass.
+    static thread_local std::vector<Float_t> buf;
+    Int_t k,n,lo,hi,tail,left=1;
+    Double_t sum=0,sx=0,sy=0,sxx=0,sxy=0,d;
+    slope=0;
+    if(BaseMethod<1 || BaseMethod>3)
+    {
+        if(right>=left) for(k=left;k<=right && k<=NP;k++) sum+=wf[k-1];
+        else for(k=left;k<=NP;k++) sum+=wf[k-1];
+        return sum/(right-left);
+    }
+    if(right<left || right>NP) right=NP;
+    n=right-left+1;
+
+    switch(BaseMethod)
+    {
+    case 1:
+    case 2:
+        buf.assign(wf,wf+n);
+        lo=(BaseMethod==2)?(Int_t)(n*BaseTrim):n/2;
+        hi=(BaseMethod==2)?n-lo:n/2+1;
+        if(hi<=lo) {lo=n/2; hi=n/2+1;}
+        std::nth_element(buf.begin(),buf.begin()+lo,buf.end());
+        if(BaseMethod==1)
+        {
+            // even number of bins: mean of the two middle bins
+            if(n%2==0) return 0.5*(buf[lo]+*std::max_element(buf.begin(),buf.begin()+lo));
+            return buf[lo];
+        }
+        std::nth_element(buf.begin()+lo,buf.begin()+hi-1,buf.end());
+        for(k=lo;k<hi;k++) sum+=buf[k];
+        return sum/(hi-lo);
+    case 3:
+        tail=(BaseTail>-1111)?TimeBin(BaseTail)-1:NP;
+        if(tail<right) tail=right;
+        for(k=0;k<n;k++) {sx+=k; sy+=wf[k]; sxx+=(Double_t)k*k; sxy+=k*(Double_t)wf[k];}
+        for(k=tail;k<NP-1;k++) {sx+=k; sy+=wf[k]; sxx+=(Double_t)k*k; sxy+=k*(Double_t)wf[k]; n++;}
+        d=n*sxx-sx*sx;
+        if(n<2 || d==0) return sy/n;
+        slope=(n*sxy-sx*sy)/d;
+        return (sy-slope*sx)/n;
+    }
+    return 0;
+}
+
 void TCTReader::CorrectPolarity(Int_t ChId)
 {
     // Function corrects the polarity of the signal (makes it negative)
-    Int_t i,j,k;
-    TH1F *his;
+    // The polarity is decided from all waveforms in every Mode, so the sign does not depend on the Mode.
+    // In Mode=3 the open stays cheap: the vote is only requested here and is taken when the first waveform
+    // of the channel is read (see Decode), which then reads the whole data part of the file once (see PolarityVote).
+    // In Mode=4 the waveforms are read slice by slice here. In Mode=3,4 the correction is applied to every waveform when it is read.
+    Int_t i,j;
+    Float_t *wf;
+    Int_t Num=numxyz*NU1*NU2; //number of all waveforms
+
+    if(!HasChannel(ChId)) return;
+    ClearProducts();
+
+    if(Mode==3) {
+        LazyVote|=1<<ChId;
+        ResetCache();
+        *Out<<"Polarity correction ("<<Num<<" waveforms) :: decided on the first reading\n";
+        return;
+    }
+
+    Int_t polarity=PolarityVote(ChId);
+
+    if(polarity<0 && Mode==4) {
+        LazyFlip[ChId]=!LazyFlip[ChId];
+        ResetCache();
+        *Out<<"Polarity correction ("<<Num<<" waveforms) :: applied on reading\n";
+    }
+    else if(polarity<0) {
+
+        for(j=0;j<Num;j++)
+        {
+            if(j==0)  *Out<<"Polarity correction ("<<Num<<" waveforms) :: ";
+
+            wf=GetWF(ChId,j);
+            for(i=0;i<NP-1;i++)
+                wf[i]=-wf[i];
+
+        }
+        *Out<<" finished\n";
+    }
+    else {
+        *Out<<"Polarity correction not needed\n";
+    }
+
+}
+
+Int_t TCTReader::PolarityVote(Int_t ChId)
+{
+    // Function returns the number of positive minus the number of negative waveforms of the channel
+    // A waveform is positive if its maximum is further from its mean than its minimum.
+    // In Mode=3 the waveforms are read in the order of the file past the cache, in pieces of contiguous
+    // records of the size of the cache, with the corrections GetWF applies.
+    Int_t i,j,j0,j1;
+    Float_t *wf;
+    std::vector<Float_t> buf;
     Double_t avg,min,max = 0;
     Double_t binval;
     Int_t Num=numxyz*NU1*NU2; //number of all waveforms
+    Long64_t wfsize=(Long64_t)NP*sizeof(Float_t);
+    Long64_t piece=(Long64_t)CacheSize*wfsize;
 
     Int_t polarity = 0;
 
-    for(j=0;j<Num;j++)
+    for(j0=0;j0<Num;j0=j1)
     {
-        max = -1e9;
-        min = 1e9;
-        if(ChId==0) his=((TH1F *)histo1->At(j));
-        if(ChId==1) his=((TH1F *)histo2->At(j));
-        if(ChId==2) his=((TH1F *)histo3->At(j));
-        if(ChId==3) his=((TH1F *)histo4->At(j));
-
-        avg=his->Integral(1,his->GetNbinsX()-1)/(his->GetNbinsX()-1);
-        for(i=1;i<his->GetNbinsX();i++)
+        j1=j0+1;
+        if(Mode==3)
         {
-            binval = his->GetBinContent(i);
-            if(binval>max) max = binval;
-            if(binval<min) min = binval;
+            while(j1<Num && Offset[ChId][j1]+wfsize-Offset[ChId][j0]<=piece) j1++;
+            buf.resize((Offset[ChId][j1-1]+wfsize-Offset[ChId][j0])/sizeof(Float_t));
+            if(!ReadAt(Offset[ChId][j0],&buf[0],buf.size()*sizeof(Float_t))) printf("Error reading waveforms %d-%d of channel %d\n",j0,j1-1,ChId+1);
         }
-        //if(j<100) std::cout<<max<<" "<<avg<<" "<<min<<std::endl;
-        if((max-avg)>=(avg-min)) polarity+=1;
-        else polarity-=1;
+        for(j=j0;j<j1;j++)
+        {
+            max = -1e9;
+            min = 1e9;
+            if(Mode==3)
+            {
+                wf=&buf[0]+(Offset[ChId][j]-Offset[ChId][j0])/sizeof(Float_t);
+                if(BLE_CODE) swooip(wf,NP);
+                LazyCorrect(ChId,wf);
+            }
+            else wf=GetWF(ChId,j);
 
+            avg=0;
+            for(i=0;i<NP-1;i++) avg+=wf[i];
+            avg/=(NP-1);
+            for(i=0;i<NP-1;i++)
+            {
+                binval = wf[i];
+                if(binval>max) max = binval;
+                if(binval<min) min = binval;
+            }
+            //if(j<100) std::cout<<max<<" "<<avg<<" "<<min<<std::endl;
+            if((max-avg)>=(avg-min)) polarity+=1;
+            else polarity-=1;
+        }
     }
+    return polarity;
+}
 
-    if(polarity<0) {
+Bool_t TCTReader::WriteBin(const Char_t *file)
+{
+    // Writes the waveforms, with all corrections applied so far, into a binary file in the byte order
+    // of the machine (little endian, as Bin=2 expects)
+    // The file has the type 33 (51 if the input has 5 coordinates) and can be read with Bin=2 in any Mode.
+    // The comment is padded so that the samples are aligned and can be used in place when mapped (Mode=1).
+    // Function returns kFALSE if the file could not be written.
+    Int_t i,ii,k,q,r,ofs=1;
+    Int_t ncord=(type==51)?5:4;
+    Int_t us=User?strlen(User):0, ss=Sample?strlen(Sample):0, cs=Comment?strlen(Comment):0, pad;
+    std::vector<Float_t> h;
+    Float_t rec[5];
+    Float_t *wf;
+    Bool_t ok=kTRUE;
+    FILE *out;
+
+    if((out=fopen(file,"wb"))==NULL) {printf("Can not write %s\n",file); return kFALSE;}
+
+    h.push_back(type==51?51:33);
+    for(i=0;i<6;i++) h.push_back(Date[i]);
+    h.push_back(abstime);
+    h.push_back(x0); h.push_back(dx); h.push_back(Nx);
+    h.push_back(y0); h.push_back(dy); h.push_back(Ny);
+    h.push_back(z0); h.push_back(dz); h.push_back(Nz);
+    for(i=0;i<3+ofs;i++) h.push_back(WFOnOff[i]);
+    h.push_back(NU1); for(i=0;i<NU1;i++) h.push_back(U1[i]);
+    h.push_back(NU2); for(i=0;i<NU2;i++) h.push_back(U2[i]);
+    h.push_back(t0); h.push_back(dt); h.push_back(NP);
+    h.push_back(T); h.push_back(Source);
+    pad=(4-(h.size()*sizeof(Float_t)+3*sizeof(Int_t)+us+ss+cs)%4)%4;
+    cs+=pad;
+
+    ok&=fwrite(&h[0],sizeof(Float_t),h.size(),out)==h.size();
+    ok&=fwrite(&us,sizeof(Int_t),1,out)==1; if(us) ok&=fwrite(User,1,us,out)==(size_t)us;
+    ok&=fwrite(&ss,sizeof(Int_t),1,out)==1; if(ss) ok&=fwrite(Sample,1,ss,out)==(size_t)ss;
+    ok&=fwrite(&cs,sizeof(Int_t),1,out)==1;
+    if(cs-pad) ok&=fwrite(Comment,1,cs-pad,out)==(size_t)(cs-pad);
+    for(i=0;i<pad;i++) fputc('\0',out);
+
+    for(q=0;q<NU1 && ok;q++)
+    {
+        for(r=0;r<NU2 && ok;r++)
+        {
+            rec[0]=U1[q]; rec[1]=U2[r]; rec[2]=I1[r+q*NU2]; rec[3]=I2[r+q*NU2];
+            ok&=fwrite(rec,sizeof(Float_t),4,out)==4;
+            for(i=0;i<numxyz && ok;i++)
+            {
+                ii=i+numxyz*r+(NU2*numxyz)*q;
+                rec[0]=xyz[0][ii]; rec[1]=xyz[1][ii]; rec[2]=xyz[2][ii]; rec[3]=xyz[7][ii];
+                if(type==51) rec[4]=xyz[8][ii];
+                ok&=fwrite(rec,sizeof(Float_t),ncord,out)==(size_t)ncord;
+                for(k=0;k<4;k++)
+                {
+                    if(WFOnOff[k]!=1) continue;
+                    wf=GetWF(k,ii);
+                    ok&=fwrite(wf,sizeof(Float_t),NP,out)==(size_t)NP;
+                }
+            }
+        }
+    }
+    if(fclose(out)!=0) ok=kFALSE;
+    if(!ok) {printf("Can not write %s\n",file); remove(file);}
+    return ok;
+}
+void TCTReader::Preprocess(Float_t xc, Int_t BaseMask, Int_t FlipMask, Int_t nth)
+{
+    // Function corrects the baseline and the polarity of the waveforms in one pass
+    // Float_t xc ; time denoting the start of the pulse (see CorrectBaseLine)
+    // Int_t BaseMask; channels (bit 0 = channel 0) which get the baseline correction
+    // Int_t FlipMask; channels which are made negative if most of their waveforms are positive (see CorrectPolarity)
+    // Int_t nth; number of threads, 0 - one per core
+    // The waveforms are split among the threads. Each waveform is corrected and its polarity vote is
+    // taken from the corrected samples while they are in cache, the sign flip of a channel needs a second
+    // pass only if the channel is mostly positive. In Mode=3,4 the corrections are applied on reading.
+    Int_t k,t;
+    Int_t Num=numxyz*NU1*NU2; //number of all waveforms
+    Int_t right=TimeBin(xc);
+    Int_t vote[4]={0,0,0,0};
+    std::vector<std::thread> pool;
 
-        for(j=0;j<Num;j++)
+    Int_t CumAll=0;
+
+    ClearProducts();
+    for(k=0;k<4;k++) if(WFOnOff[k]!=1) {BaseMask&=~(1<<k); FlipMask&=~(1<<k);}
+
+    if(Mode==3 || Mode==4)
+    {
+        LazyBaseLine=BaseMask;
+        LazyXc=xc;
+        ResetCache();
+        *Out<<"Baseline correction ("<<Num<<" waveforms) :: applied on reading\n";
+        for(k=0;k<4;k++) if(FlipMask&(1<<k)) CorrectPolarity(k);
+        BuildIntegrals();
+        return;
+    }
+
+    // prefix sums are made in the same pass
+    for(k=0;k<4;k++)
+        if((CumMask&(1<<k)) && WFOnOff[k]==1)
         {
-            if(j==0)  std::cout<<"Polarity correction ("<<Num<<" waveforms) :: ";
+            if(Cum[k]==NULL) Cum[k]=new Double_t[(Long64_t)Num*(NP+1)];
+            CumAll|=1<<k;
+        }
 
-            if(ChId==0) his=((TH1F *)histo1->At(j));
-            if(ChId==1) his=((TH1F *)histo2->At(j));
-            if(ChId==2) his=((TH1F *)histo3->At(j));
-            if(ChId==3) his=((TH1F *)histo4->At(j));
+    if(nth<=0) nth=std::thread::hardware_concurrency();
+    if(nth<1) nth=1;
+    if(nth>Num) nth=Num>0?Num:1;
+    std::vector<Int_t> votes(4*nth,0);
+    *Out<<"Baseline and polarity correction ("<<Num<<" waveforms, "<<nth<<" threads) :: ";
 
-            for(i=1;i<his->GetNbinsX();i++)
-                his->SetBinContent(i,-(his->GetBinContent(i)));
+    auto correct=[&](Int_t t)
+    {
+        Int_t i,j,k;
+        Float_t *wf,v;
+        Double_t corr,slope,avg,min,max,*c;
+        for(j=Num*(Long64_t)t/nth;j<Num*(Long64_t)(t+1)/nth;j++)
+            for(k=0;k<4;k++)
+            {
+                if(!((BaseMask|FlipMask|CumAll)&(1<<k))) continue;
+                wf=GetWF(k,j);
+                corr=slope=0;
+                if(BaseMask&(1<<k)) corr=BaseLine(wf,right,slope);
+                avg=0; max=-1e9; min=1e9;
+                for(i=0;i<NP-1;i++)
+                {
+                    v=wf[i]-(corr+slope*i);
+                    wf[i]=v;
+                    avg+=v;
+                    if(v>max) max=v;
+                    if(v<min) min=v;
+                }
+                if(CumAll&(1<<k))
+                {
+                    c=Cum[k]+(Long64_t)j*(NP+1);
+                    c[0]=0;
+                    for(i=0;i<NP;i++) c[i+1]=c[i]+wf[i];
+                }
+                avg/=(NP-1);
+                if((max-avg)>=(avg-min)) votes[4*t+k]++; else votes[4*t+k]--;
+            }
+    };
+    for(t=0;t<nth;t++) pool.push_back(std::thread(correct,t));
+    for(t=0;t<nth;t++) pool[t].join();
+    for(t=0;t<nth;t++) for(k=0;k<4;k++) vote[k]+=votes[4*t+k];
+    *Out<<" finished\n";
 
+    FlipMask&=(vote[0]<0)|((vote[1]<0)<<1)|((vote[2]<0)<<2)|((vote[3]<0)<<3);
+    if(FlipMask==0) {*Out<<"Polarity correction not needed\n"; return;}
+
+    *Out<<"Polarity correction ("<<Num<<" waveforms) :: ";
+    auto flip=[&](Int_t t)
+    {
+        Int_t i,j,k;
+        Float_t *wf;
+        Double_t *c;
+        for(j=Num*(Long64_t)t/nth;j<Num*(Long64_t)(t+1)/nth;j++)
+            for(k=0;k<4;k++)
+            {
+                if(!(FlipMask&(1<<k))) continue;
+                wf=GetWF(k,j);
+                for(i=0;i<NP-1;i++) wf[i]=-wf[i];
+                if(!(CumAll&(1<<k))) continue;
+                // the last sample is not flipped
+                c=Cum[k]+(Long64_t)j*(NP+1);
+                for(i=1;i<NP;i++) c[i]=-c[i];
+                c[NP]=c[NP-1]+wf[NP-1];
+            }
+    };
+    pool.clear();
+    for(t=0;t<nth;t++) pool.push_back(std::thread(flip,t));
+    for(t=0;t<nth;t++) pool[t].join();
+    *Out<<" finished\n";
+}
+
+void TCTReader::SetIntegrals(Int_t mask)
+{
+    // Selects the channels (bit 0 = channel 0) which get the prefix sums of their samples
+    // The sums are made by Preprocess in its pass over the waveforms, or by BuildIntegrals.
+    // With the sums the integral of a waveform in any time window takes two lookups (see Integral).
+    // They need 2*(NP+1)/NP times the memory of the samples of the channel.
+    CumMask=mask&15;
+}
+
+void TCTReader::BuildIntegrals()
+{
+    // Makes the prefix sums of the channels selected by SetIntegrals from the current samples
+    // Needed when the waveforms were not corrected by Preprocess (e.g. read from the cache).
+    // Modes 0-2 are split among the threads, in Mode=3,4 the waveforms are read once in order.
+    Int_t k,t,nth=1;
+    Int_t Num=numxyz*NU1*NU2; //number of all waveforms
+    Int_t CumAll=0;
+    std::vector<std::thread> pool;
+
+    for(k=0;k<4;k++)
+        if((CumMask&(1<<k)) && WFOnOff[k]==1)
+        {
+            if(Cum[k]==NULL) Cum[k]=new Double_t[(Long64_t)Num*(NP+1)];
+            CumAll|=1<<k;
         }
-        std::cout<<" finished\n";
-    }
-    else {
-        std::cout<<"Polarity correction not needed\n";
-    }
+    if(CumAll==0) return;
 
+    if(Mode!=3 && Mode!=4) nth=std::thread::hardware_concurrency();
+    if(nth<1) nth=1;
+    if(nth>Num) nth=Num>0?Num:1;
+    auto build=[&](Int_t t)
+    {
+        Int_t i,j,k;
+        Float_t *wf;
+        Double_t *c;
+        for(j=Num*(Long64_t)t/nth;j<Num*(Long64_t)(t+1)/nth;j++)
+            for(k=0;k<4;k++)
+            {
+                if(!(CumAll&(1<<k))) continue;
+                wf=GetWF(k,j);
+                c=Cum[k]+(Long64_t)j*(NP+1);
+                c[0]=0;
+                for(i=0;i<NP;i++) c[i+1]=c[i]+wf[i];
+            }
+    };
+    if(nth==1) {build(0); return;}
+    for(t=0;t<nth;t++) pool.push_back(std::thread(build,t));
+    for(t=0;t<nth;t++) pool[t].join();
+}
+
+Double_t TCTReader::Integral(Int_t ch, Int_t index, Float_t mint, Float_t maxt)
+{
+    // Function returns the integral of the waveform in the time window, as TCTWaveform::Integral
+    // Int_t ch; channel number
+    // Int_t index; index of the waveform (see indx)
+    // Float_t mint, maxt; time window, -1111 - from the first bin / to the bin before the last one
+    // Two lookups if the prefix sums of the channel exist, otherwise the samples are summed.
+    Int_t i,lo,hi;
+    Double_t sum=0;
+    Double_t width=(((NP*dt+t0)*1e9-Time0)-(t0*1e9-Time0))/NP;
+    Float_t *wf;
+
+    lo=(mint==-1111)?1:TimeBin(mint);
+    hi=(maxt==-1111)?NP-1:TimeBin(maxt);
+    // same ranges as TH1::Integral, the underflow and overflow bins are empty
+    if(hi>NP || hi<lo) hi=NP;
+    if(lo<1) lo=1;
+    if(lo>hi) return 0;
+
+    if(Cum[ch]!=NULL) return (Cum[ch][(Long64_t)index*(NP+1)+hi]-Cum[ch][(Long64_t)index*(NP+1)+lo-1])*width;
+    wf=GetWF(ch,index);
+    if(wf==NULL) return 0;
+    for(i=lo;i<=hi;i++) sum+=wf[i-1];
+    return sum*width;
+}
+
+void TCTReader::Integrals(Int_t ch, Float_t mint, Float_t maxt, Float_t *out, Int_t nth)
+{
+    // Fills out with the integrals (see Integral) of all waveforms of the channel in the time window
+    // Int_t ch; channel number
+    // Float_t mint, maxt; time window, -1111 - from the first bin / to the bin before the last one
+    // Float_t *out; dense array of numxyz*NU1*NU2 values (all x,y,z,U1,U2), ordered as indx
+    // Int_t nth; number of threads, 0 - all cores (Mode=3,4 always use one, the file is read in order)
+    // The integrals are taken from the prefix sums if they exist, otherwise the bins of the
+    // window are summed with four partial sums, so the compiler can keep them in vector registers.
+    Int_t t,lo,hi;
+    Int_t Num=numxyz*NU1*NU2; //number of all waveforms
+    Double_t width=(((NP*dt+t0)*1e9-Time0)-(t0*1e9-Time0))/NP;
+    std::vector<std::thread> pool;
+
+    lo=(mint==-1111)?1:TimeBin(mint);
+    hi=(maxt==-1111)?NP-1:TimeBin(maxt);
+    // same ranges as TH1::Integral, the underflow and overflow bins are empty
+    if(hi>NP || hi<lo) hi=NP;
+    if(lo<1) lo=1;
+
+    if(nth<=0) nth=std::thread::hardware_concurrency();
+    if(Mode==3 || Mode==4 || nth<1) nth=1;
+    if(nth>Num) nth=Num>0?Num:1;
+    auto kernel=[&](Int_t t)
+    {
+        Int_t i,j;
+        Float_t *wf;
+        Double_t *c,s0,s1,s2,s3;
+        for(j=Num*(Long64_t)t/nth;j<Num*(Long64_t)(t+1)/nth;j++)
+        {
+            if(lo>hi) {out[j]=0; continue;}
+            if(Cum[ch]!=NULL)
+            {
+                c=Cum[ch]+(Long64_t)j*(NP+1);
+                out[j]=(c[hi]-c[lo-1])*width;
+                continue;
+            }
+            wf=GetWF(ch,j);
+            if(wf==NULL) {out[j]=0; continue;}
+            s0=s1=s2=s3=0;
+            for(i=lo-1;i+3<hi;i+=4) {s0+=wf[i]; s1+=wf[i+1]; s2+=wf[i+2]; s3+=wf[i+3];}
+            for(;i<hi;i++) s0+=wf[i];
+            out[j]=((s0+s1)+(s2+s3))*width;
+        }
+    };
+    if(nth==1) {kernel(0); return;}
+    for(t=0;t<nth;t++) pool.push_back(std::thread(kernel,t));
+    for(t=0;t<nth;t++) pool[t].join();
+}
+
+const Float_t *TCTReader::ChargeMap(Int_t ch, Float_t mint, Float_t maxt, Int_t nth)
+{
+    // Function returns the integrals of all waveforms of the channel in the time window (see Integrals)
+    // The map is made once for each channel and window and kept until the waveforms are corrected
+    // again, so all modules analysing the file share it. The array belongs to the reader.
+    Int_t Num=numxyz*NU1*NU2;
+    for(UInt_t i=0;i<Maps.size();i++)
+        if(Maps[i].ch==ch && Maps[i].mint==mint && Maps[i].maxt==maxt) return Maps[i].map;
+
+    ChargeMapEntry e;
+    e.ch=ch; e.mint=mint; e.maxt=maxt;
+    e.map=new Float_t[Num];
+    Integrals(ch,mint,maxt,e.map,nth);
+    Maps.push_back(e);
+    return e.map;
 }
 
+Bool_t TCTReader::GetProduct(ULong64_t key, std::vector<Double_t> &val)
+{
+    // Function gets the result stored under the key by SetProduct, kFALSE if there is none
+    std::map<ULong64_t, std::vector<Double_t> >::iterator it=Products.find(key);
+    if(it==Products.end()) return kFALSE;
+    val=it->second;
+    return kTRUE;
+}
+
+void TCTReader::SetProduct(ULong64_t key, const std::vector<Double_t> &val)
+{
+    // Stores a result of the analysis of the waveforms (e.g. fitted edges) under the key
+    // The key must describe all inputs of the result, e.g. a hash of the analysed data.
+    Products[key]=val;
+}
+
+void TCTReader::ClearProducts()
+{
+    // Removes the charge maps and the stored results, called when the waveforms change
+    for(UInt_t i=0;i<Maps.size();i++) delete [] Maps[i].map;
+    Maps.clear();
+    Products.clear();
+}
 
 void TCTReader::PrintInfo()
 {
@@ -1008,14 +1998,8 @@ void  TCTReader::swoo(char *a, char *b) {
 }
 
 void TCTReader::swooip(float *in, int s) {
-    // byte swaping (LABVIEW,HPUX g++)<->(LINUX g++, WINNT cl)
-    char *sr, b;
-    while(s--) {
-        sr=(char *)in;
-        swoo(&sr[0], &sr[3]);
-        swoo(&sr[1], &sr[2]);
-        in++;
-    }
+    // byte swaping (LABVIEW,HPUX g++)<->(LINUX g++, WINNT cl), see TCT::SwapBytes
+    TCT::SwapBytes(in,s);
 }
 
 TCTWaveform::TCTWaveform(Int_t num)
@@ -1043,12 +2027,16 @@ TCTWaveform::TCTWaveform(Int_t num)
     strcpy(prefix,"U=");
 
     pt=NULL;
+    Reader=NULL;
+    Channel=0;
+    Index=NULL;
 }
 
 TCTWaveform::~TCTWaveform()
 {
     // Destructor
     if(pt!=NULL) delete pt;
+    delete [] Index;
     //Clear();
     if(histo) {
         delete histo;
@@ -1072,6 +2060,20 @@ void TCTWaveform::AddHisto(Int_t index,Float_t voltage,TH1F *hisin)
     }
 }
 
+void TCTWaveform::SetSource(TCTReader *reader,Int_t ch,Int_t *index)
+{
+    // Remembers where the waveforms come from, the integrals are then taken from the
+    // prefix sums of the reader if it has them (see TCTReader::SetIntegrals)
+    // The reader must not be deleted before this object.
+    // 		TCTReader *reader ;  reader of the waveforms
+    // 		Int_t ch          ;  channel
+    // 		Int_t *index      ;  Multiple indices of the waveforms in the reader
+    Reader=reader;
+    Channel=ch;
+    if(Index==NULL) Index=new Int_t[Multiple];
+    for(Int_t i=0;i<Multiple;i++) Index[i]=index[i];
+}
+
 void TCTWaveform::AddHisto(Float_t voltage,TH1F *hisin)
 {
     // Add histogram (waveform)
@@ -1194,6 +2196,8 @@ Float_t TCTWaveform::Integral(Int_t i,Float_t mint, Float_t maxt)
     Int_t mintime;
     Int_t maxtime;
 
+    if(Reader && Reader->HasIntegrals(Channel)) return(Reader->Integral(Channel,Index[i],mint,maxt));
+
     TH1F *his=((TH1F *)histo->At(i));
     if (maxt==-1111) maxtime=his->GetNbinsX()-1; else maxtime=his->GetXaxis()->FindBin(maxt);
     if (mint==-1111) mintime=1; else mintime=his->GetXaxis()->FindBin(mint);
@@ -1228,11 +2232,15 @@ void TCTWaveform::GetIntegral(Float_t *x,Float_t *y,Float_t scale,Float_t mint,
     TH1F *his;
     for(i=0;i<Multiple;i++)
     {
-        his=((TH1F *)histo->At(i));
-        if (maxt==-1111) maxtime=his->GetNbinsX()-1; else maxtime=his->GetXaxis()->FindBin(maxt);
-        if (mint==-1111) mintime=1; else mintime=his->GetXaxis()->FindBin(mint);
-        //	printf("%d ,%d\n",mintime,maxtime);
-        y[i]=his->Integral(mintime,maxtime)*his->GetBinWidth(1)/scale;
+        if(Reader && Reader->HasIntegrals(Channel)) y[i]=Reader->Integral(Channel,Index[i],mint,maxt)/scale;
+        else
+        {
+            his=((TH1F *)histo->At(i));
+            if (maxt==-1111) maxtime=his->GetNbinsX()-1; else maxtime=his->GetXaxis()->FindBin(maxt);
+            if (mint==-1111) mintime=1; else mintime=his->GetXaxis()->FindBin(mint);
+            //	printf("%d ,%d\n",mintime,maxtime);
+            y[i]=his->Integral(mintime,maxtime)*his->GetBinWidth(1)/scale;
+        }
         if(Voltages[i]!=0 || Voltages[i+1]!=0) x[i]=Voltages[i]; else x[i]=(Float_t)i;
     }
 }
@@ -0,0 +1,64 @@
+/**
+ * \file
+ * \brief Implementation of the byte swapping functions.
+ */
+
+// STD includes
+#include <string.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// TCT includes
+#include "TCTSwap.h"
+
+namespace TCT {
+
+void SwapBytes(float *in, int s) {
+    // byte swaping (LABVIEW,HPUX g++)<->(LINUX g++, WINNT cl)
+    // Blocks of floats are swapped with the widest vector instructions the code was built for
+    // (AVX2, SSSE3 or SSE2, see WITH_NATIVE_ARCH), the rest one by one.
+    unsigned int u;
+#if defined(__AVX2__)
+    const __m256i mask=_mm256_set_epi8(12,13,14,15,8,9,10,11,4,5,6,7,0,1,2,3,
+                                       12,13,14,15,8,9,10,11,4,5,6,7,0,1,2,3);
+    for(;s>=8;s-=8,in+=8)
+        _mm256_storeu_si256((__m256i *)in,_mm256_shuffle_epi8(_mm256_loadu_si256((__m256i *)in),mask));
+#elif defined(__SSSE3__)
+    const __m128i mask=_mm_set_epi8(12,13,14,15,8,9,10,11,4,5,6,7,0,1,2,3);
+    for(;s>=4;s-=4,in+=4)
+        _mm_storeu_si128((__m128i *)in,_mm_shuffle_epi8(_mm_loadu_si128((__m128i *)in),mask));
+#elif defined(__SSE2__)
+    __m128i v;
+    for(;s>=4;s-=4,in+=4)
+    {
+        v=_mm_loadu_si128((__m128i *)in);
+        // swap the bytes in 16 bit words, then the words in 32 bit floats
+        v=_mm_or_si128(_mm_slli_epi16(v,8),_mm_srli_epi16(v,8));
+        v=_mm_shufflehi_epi16(_mm_shufflelo_epi16(v,0xB1),0xB1);
+        _mm_storeu_si128((__m128i *)in,v);
+    }
+#endif
+    while(s--) {
+        memcpy(&u,in,4);
+        u=(u>>24)|((u>>8)&0xFF00)|((u<<8)&0xFF0000)|(u<<24);
+        memcpy(in,&u,4);
+        in++;
+    }
+}
+
+void SwapBytesScalar(float *in, int s) {
+    char *sr, b;
+    while(s--) {
+        sr=(char *)in;
+        b=sr[0]; sr[0]=sr[3]; sr[3]=b;
+        b=sr[1]; sr[1]=sr[2]; sr[2]=b;
+        in++;
+    }
+}
+
+}
@@ -30,74 +30,48 @@ namespace TCT {
     std::cout << "start ACQ_single::Read"  << std::endl;
 #endif
 
+    if(!Parse(infile)) exit(1);
+    MakeHistograms(iFile);
 
-    int ret=0;
-    float t_off=0;
+#ifdef DEBUG 
+    std::cout << "end ACQ_single::Read"  << std::endl;
+#endif
+
+    return kTRUE;
+  }
+
+  // reads the samples of a text file and sets the polarity, no ROOT objects are made,
+  // so files can be parsed in several threads (see measurement::AcqsLoader)
+  bool acquisition_single::Parse(FILE *infile){
 
-    Char_t dummy[20];
-    // pre-parse to find polarity
-    double in_v, in_t;
+    float t_off=0;
     float minvolt = 1.;
     float maxvolt = -1.;
-    uint32_t counter = 0;
-    for(Int_t k=0; k<30; k++){
-      ret = fscanf(infile,"%s",dummy);
-      //std::cout << "ret = " << ret << " k = " << k << " " << " dummy = " << dummy << "    ";
-    }
-    while(1)
-    {
-      ret = fscanf(infile,"%lf",&in_t);
-      ret = fscanf(infile,"%lf",&in_v);
-      if(feof(infile)) break;
-      if(in_v > maxvolt) maxvolt = in_v;
-      if(in_v < minvolt) minvolt = in_v;
-
-      if (ret<=0) 
-      {
-	std::cout << "read error voltage block at position i = " << counter << "\n";
-	exit(1);
-      }
-      counter++;
 
+    // read pulse waveform, the same pass finds the extremes of the voltage for the polarity
+    if(!ParseSamples(infile, volt, minvolt, maxvolt))
+    {
+	std::cout << "read error voltage block at position i = " << volt.size() << "\n";
+	return kFALSE;
     }
+    uint32_t counter = volt.size();
 
     if(maxvolt > fabs(minvolt)) SetPolarity(1.);
     else SetPolarity(-1.);
     //if(BiasVolt() < 0) Polarity = 1.;
 
-    rewind(infile);
-    // read header to dummy again
-    for(Int_t k=0; k<30; k++){
-      ret = fscanf(infile,"%s",dummy);
-      //if(debug>9) std::cout << k << " " << dummy << "    ";
-    }
-
-    // read pulse waveform
-    counter = 0;
-    while(1)
-    {
-      //std::cout << "\n4 " << std::endl;
-      ret = fscanf(infile,"%lf",&in_t);
-      ret = fscanf(infile,"%lf",&in_v);
-      if(feof(infile)) break;
-
-      //if(counter < 5) std::cout << counter << " in_t: " << in_t;
-      //if(counter < 5) std::cout << "  " << counter << " in_v: " << in_v << " ";
-      //if(counter < 5) std::cout << SampleInterval();
-
-      if (ret<=0) 
-      {
-	std::cout << "read error voltage block at position i = " << counter << "\n";
-	exit(1);
-      }
-
-      time.push_back(t_off+counter*SampleInterval());
-      volt.push_back(Polarity()*in_v);
-      counter++;
-    }
+    double polarity = Polarity();
+    for(uint32_t i=0; i<counter; i++) volt[i] *= polarity;
+    time.resize(counter);
+    for(uint32_t i=0; i<counter; i++) time[i] = t_off+i*SampleInterval();
 
     SetNsamples(counter);
 
+    return kTRUE;
+  }
+
+  // histograms of the acquisition, made after Parse or ParseRAW in the main thread
+  void acquisition_single::MakeHistograms(uint32_t iFile){
 
     // fill histogram and add to Object array // !! next 6 lines to be moved to the constructor
     Char_t buffername [50];
@@ -112,13 +86,6 @@ namespace TCT {
 
     this->SetName("SingleAcq");
     //this->PrintAcq();
-
-#ifdef DEBUG 
-    std::cout << "end ACQ_single::Read"  << std::endl;
-#endif
-
-
-    return kTRUE;
   }
 #ifdef USE_LECROY_RAW
   bool acquisition_single::ReadRAW(std::string fullfname, uint32_t iFile){
@@ -126,6 +93,20 @@ namespace TCT {
 	#ifdef DEBUG 
 	    std::cout << "start ACQ_single::ReadRAW"  << std::endl;
 	#endif
+
+	ParseRAW(fullfname);
+	MakeHistograms(iFile);
+
+	#ifdef DEBUG 
+	    std::cout << "end ACQ_single::ReadRAW"  << std::endl;
+	#endif
+
+	return kTRUE;
+  }
+
+  // same as Parse for LeCroy binary files
+  bool acquisition_single::ParseRAW(std::string fullfname){
+
 	LeCroy::waveFile thisFile(fullfname);
 
 	int ret=0;
@@ -157,25 +138,7 @@ namespace TCT {
 
     	SetNsamples(thisFile.WAVE_ARRAY_COUNT);
 
-	// fill histogram and add to Object array // !! next 6 lines to be moved to the constructor
-	Char_t buffername [50];
-	Char_t buffername2 [50];
-	sprintf (buffername, "Pulse_%d", (int)iFile);
-	sprintf (buffername2, "Pulse_%d-FILTERED", (int)iFile);
-
-	_H_acquisition = new TH1F(buffername, buffername, Nsamples(), time[0]-SampleInterval()*0.5, time[Nsamples()-1]+SampleInterval()*0.5);
-	_H_acquisitionFILTERED = new TH1F(buffername2, buffername2, Nsamples(), time[0]-SampleInterval()*0.5, time[Nsamples()-1]+SampleInterval()*0.5);
-
-	this->SetName("SingleAcq");
-	//this->PrintAcq();
-
-	#ifdef DEBUG 
-	    std::cout << "end ACQ_single::ReadRAW"  << std::endl;
-	#endif
-
 	return kTRUE;
-
-	
   }
 #else
   bool acquisition_single::ReadRAW(std::string fullfname, uint32_t iFile){
@@ -184,6 +147,13 @@ namespace TCT {
 
     return kFALSE;
   }
+
+  bool acquisition_single::ParseRAW(std::string fullfname){
+
+    std::cout<<"Impossible without LeCroy Library. Recompile Application with -DWITH_LECROY_RAW=ON flag."<<std::endl;
+
+    return kFALSE;
+  }
 #endif
 
   void acquisition_single::SetName(std::string name){
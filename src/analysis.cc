@@ -28,6 +28,7 @@ namespace TCT {
     for( auto i : id_val){
       //if(i.first == "") _ = atof((i.second).c_str());
       if(i.first == "MaxAcqs")		_MaxAcqs = atoi((i.second).c_str());
+      if(i.first == "StreamAcqs")	_StreamAcqs = atoi((i.second).c_str());
       if(i.first == "AmplNegLate_Cut")	_AmplNegLate_Cut = atof((i.second).c_str());
       if(i.first == "AmplPosLate_Cut")	_AmplPosLate_Cut = atof((i.second).c_str());
       if(i.first == "AmplNegEarly_Cut")	_AmplNegEarly_Cut = atof((i.second).c_str());
@@ -232,6 +233,57 @@ namespace TCT {
 
   }
 
+  void analysis::AcqsProcessor(std::vector<TCT::acquisition_single> *acqs, uint32_t first, TCT::acquisition_avg *acqAvg, int *Nselected, std::vector<TCT::acquisition_single> *singles) {
+    /** The acquisitions are treated in the order of the files, so the result does not depend on
+     *  the size of the blocks. Afterwards the histograms and samples of the acquisitions are freed
+     *  and acqs is emptied; if the single acquisitions are written (SaveToFile and SaveSingles),
+     *  their pulse histograms are moved to singles.
+     *  \param[in] first Index of the first acquisition of the block in the folder
+     *  \param[in,out] Nselected Number of selected acquisitions
+     */
+
+#ifdef DEBUG
+    std::cout << "start ANA::AcqsProcessor" << std::endl;
+#endif
+
+    for(uint32_t i_acq = 0; i_acq < acqs->size(); i_acq++){
+
+      TCT::acquisition_single* acq = &acqs->at(i_acq);
+      if(DoSmearing()) AcqsSmearer(acq, AddNoise(), false);
+      AcqsAnalyser(acq, first+i_acq, acqAvg);
+      if(DoSmearing()) AcqsSmearer(acq, false, AddJitter()); // AcqsAnalyser removes jitter by determining each acqs delay. Hence, to add jitter, delay has to be manipulated after AcqsAnalyser (and before filling of profile
+
+#ifdef DEBUG
+      std::cout << *acq << std::endl;
+#endif
+
+      if( AcqsSelecter(acq) ) {
+        (*Nselected)++;
+        acq->SetSelect(true);
+      }
+      acqAvg->SetNselected(*Nselected);
+      AcqsProfileFiller(acq, acqAvg);
+
+    }
+
+    // now take care of memory management
+    for(uint32_t i_acq = 0; i_acq < acqs->size(); i_acq++){
+      if(SaveToFile() && SaveSingles()) {
+        acqs->at(i_acq).Strip();
+        singles->push_back(acqs->at(i_acq));
+      }
+      else acqs->at(i_acq).Clear();
+    }
+    acqs->clear();
+
+#ifdef DEBUG
+    std::cout << "end ANA::AcqsProcessor" << std::endl;
+#endif
+
+    return;
+
+  }
+
   void analysis::AcqsWriter(std::vector<TCT::acquisition_single> *allAcqs, TCT::acquisition_avg *acqAvg, bool HasSubs){
 
 #ifdef DEBUG
@@ -9,6 +9,7 @@
 //Qt includes
 #include "ui_base.h"
 #include "QFileDialog"
+#include "QFileInfo"
 #include "ui_form_parameters.h"
 #include "ui_form_sample.h"
 #include "ui_form_folders.h"
@@ -31,6 +32,7 @@
 
 #include <TCTModule.h>
 #include <TCTReader.h>
+#include <TCTCatalog.h>
 
 //ROOT includes
 #include <TSystem.h>
@@ -473,13 +475,18 @@ void base::start_tct() {
     QDebugStream *debug = new QDebugStream(std::cout, log_file, progress->Console());
     print_run(true);
 
+    // the next file is read and corrected while the modules work on the current one
+    TCT::Prefetch prefetch;
     for(int i=0;i<names.length();i++) {
         if(progress->wasCanceled()) break;
+        TCTReader *reader;
+        ULong64_t hash = prefetch.Wait(names.at(i).toStdString(),&reader);
+        if(i+1<names.length()) prefetch.Start(names.at(i+1).toStdString(),config_tct);
         ui->statusBar->showMessage(QString("Reading file %1").arg(names.at(i).split("/").last()),1000);
         char pathandfile[250];
         strcpy(pathandfile,names.at(i).toStdString().c_str());
         TCT::Scanning daq_data;
-        bool read = daq_data.ReadTCT(pathandfile,config_tct,progress);
+        bool read = daq_data.ReadTCT(pathandfile,config_tct,progress,hash,reader);
         if(!read) {
             ui->statusBar->showMessage(QString("Processing of file %1 failed. Skipping").arg(names.at(i).split("/").last()));
             continue;
@@ -534,10 +541,13 @@ void base::start_osc()
         if(subdir.entryList(filter).length()) {
             std::vector<TCT::acquisition_single> AllAcqs;
             TCT::measurement meas(dirname.toStdString());
-            if(!meas.AcqsLoader(&AllAcqs, config_analysis->MaxAcqs(),config_analysis->LeCroyRAW())) {
+            uint32_t Nacqs = meas.AcqsLister(config_analysis->MaxAcqs(),config_analysis->LeCroyRAW());
+            uint32_t block = config_analysis->StreamAcqs() > 0 ? config_analysis->StreamAcqs() : Nacqs;
+            if(Nacqs == 0 || !meas.AcqsBlockLoader(&AllAcqs, 0, block, config_analysis->LeCroyRAW())) {
                 std::cout << " Folder empty! Skipping folder" << std::endl;
                 continue;
             };
+            std::vector<TCT::acquisition_single> Singles;
             // now create instance of avg acquisition using Nsamples from loaded files
             TCT::acquisition_avg AcqAvg(AllAcqs[0].Nsamples());
             AcqAvg.SetPolarity(AllAcqs[0].Polarity());
@@ -545,21 +555,10 @@ void base::start_osc()
             //now analyse all acquisitions
             int Nselected = 0;
 
-            AcqAvg.SetNanalysed(AllAcqs.size());
-            for(uint32_t i_acq = 0; i_acq < AllAcqs.size(); i_acq++){
-
-                TCT::acquisition_single* acq = &AllAcqs[i_acq];
-                if(config_analysis->DoSmearing()) config_analysis->AcqsSmearer(acq, config_analysis->AddNoise(), false);
-                config_analysis->AcqsAnalyser(acq, i_acq, &AcqAvg);
-                if(config_analysis->DoSmearing()) config_analysis->AcqsSmearer(acq, false, config_analysis->AddJitter()); // AcqsAnalyser removes jitter by determining each acqs delay. Hence, to add jitter, delay has to be manipulated after AcqsAnalyser (and before filling of profile
-
-                if( config_analysis->AcqsSelecter(acq) ) {
-                    Nselected++;
-                    acq->SetSelect(true);
-                }
-                AcqAvg.SetNselected(Nselected);
-                config_analysis->AcqsProfileFiller(acq, &AcqAvg);
-
+            AcqAvg.SetNanalysed(Nacqs);
+            for(uint32_t first = 0; first < Nacqs; first += block) {
+                if(first > 0) meas.AcqsBlockLoader(&AllAcqs, first, block, config_analysis->LeCroyRAW());
+                config_analysis->AcqsProcessor(&AllAcqs, first, &AcqAvg, &Nselected, &Singles);
             }
 
             config_analysis->SetOutSample_ID(config_sample->SampleID());
@@ -568,18 +567,18 @@ void base::start_osc()
 
 
             if(config_analysis->SaveToFile())
-                config_analysis->AcqsWriter(&AllAcqs, &AcqAvg, true);
-                //else config_analysis->AcqsWriter(&AllAcqs, &AcqAvg, false);
+                config_analysis->AcqsWriter(&Singles, &AcqAvg, true);
+                //else config_analysis->AcqsWriter(&Singles, &AcqAvg, false);
 
             std::cout << "   Nselected = " << Nselected << std::endl;
-            std::cout << "   ratio of selected acqs = " << Nselected << " / " << AllAcqs.size() << " = " << (float)Nselected/AllAcqs.size()*100. << "%\n\n" << std::endl;
+            std::cout << "   ratio of selected acqs = " << Nselected << " / " << Nacqs << " = " << (float)Nselected/Nacqs*100. << "%\n\n" << std::endl;
 
             // now take care of memory management
-            // delete remaning TH1Fs in acquisition_single and then clear AllAcqs
-            for(int j = 0; j < AllAcqs.size(); j++) {
-                AllAcqs[j].Clear();
+            // delete remaning TH1Fs of the kept acquisitions and then clear Singles
+            for(int j = 0; j < Singles.size(); j++) {
+                Singles[j].Clear();
             }
-            AllAcqs.clear();
+            Singles.clear();
 
             countersubdir++;
         }
@@ -650,6 +649,8 @@ void base::on_actionSave_config_triggered()
 
     conf_file<<"\n\n[Analysis]";
     conf_file<<"\nMaxAcqs\t=\t"<<config_analysis->MaxAcqs();
+    conf_file<<"\n#Number of acquisitions read and analysed at once, 0 - all (the memory grows with MaxAcqs)";
+    conf_file<<"\nStreamAcqs\t=\t"<<config_analysis->StreamAcqs();
     conf_file<<"\nNoise_Cut\t=\t"<<config_analysis->Noise_Cut();
     conf_file<<"\nNoiseEnd_Cut\t=\t"<<config_analysis->NoiseEnd_Cut();
     conf_file<<"\nS2n_Cut\t=\t"<<config_analysis->S2n_Cut();
@@ -683,6 +684,28 @@ void base::on_actionSave_config_triggered()
     conf_file<<"\nMovements_dt\t=\t"<<config_tct->Movements_dt();
     conf_file<<"\n#Set the integration time in ns to correct the bias line. Program averages the signal in range (0,value) and then shifts the signal by the mean value.";
     conf_file<<"\nCorrectBias\t=\t"<<config_tct->CorrectBias();
+    conf_file<<"\n#Estimator of the baseline: 0 - mean, 1 - median, 2 - trimmed mean (BaselineTrim cut on each side), 3 - line fitted before the pulse and after BaselineTail (ns, -1111 - no tail).";
+    conf_file<<"\nBaselineMethod\t=\t"<<config_tct->BaselineMethod();
+    conf_file<<"\nBaselineTrim\t=\t"<<config_tct->BaselineTrim();
+    conf_file<<"\nBaselineTail\t=\t"<<config_tct->BaselineTail();
+    conf_file<<"\n#Prefix sums of the detector and photodiode waveforms (1 - on), charges in any time window are then taken in constant time. Needs about 2x the memory of the waveforms.";
+    conf_file<<"\nIntegralTables\t=\t"<<config_tct->IntegralTables();
+    // the dedicated fitter is written only if it was set by hand, it is not yet compared with Minuit under ROOT 5
+    if(config_tct->FastFit()) {
+        conf_file<<"\n#Fit of the edges and strips of the charge profiles with the dedicated Levenberg-Marquardt fitter (1) instead of ROOT (0), not yet compared with Minuit under ROOT 5 (test/bench_fitter_root).";
+        conf_file<<"\nFastFit\t=\t"<<config_tct->FastFit();
+    }
+    conf_file<<"\n#Start the fit of each optical position from the result of the previous one (1 - on), the start values are used if that fit fails.";
+    conf_file<<"\nFitContinuation\t=\t"<<config_tct->FitContinuation();
+    conf_file<<"\n#Reading of the data file: 0 - all waveforms are read into histograms, 1 - file is memory mapped, histograms are built on request, 2 - samples are kept in contiguous arrays, histograms are built on request, 3 - waveforms are read on request, 4 - file is read one voltage slice at a time.";
+    conf_file<<"\nReaderMode\t=\t"<<config_tct->ReaderMode();
+    conf_file<<"\n#Number of waveforms kept in memory when they are read on request (ReaderMode 3).";
+    conf_file<<"\nReaderCache\t=\t"<<config_tct->ReaderCache();
+    conf_file<<"\n#Folder where the corrected waveforms are kept, so the next analysis of the same file skips reading and corrections.";
+    if(config_tct->CacheFolder() != "") conf_file<<"\nCacheFolder\t=\t"<<config_tct->CacheFolder();
+    else conf_file<<"\n#CacheFolder\t=\t<folder>";
+    conf_file<<"\n#Number of .tct files of the data folder analysed at the same time (console version, also -j <number>), each file then uses one thread.";
+    conf_file<<"\nThreads\t=\t"<<config_tct->Threads();
 
     conf_file<<"\n#Perform next operations. Analysis will start only if all needed data is present:";
     conf_file<<"\n# 0-top,1-edge,2-bottom";
@@ -746,6 +769,10 @@ void base::on_actionSave_config_triggered()
     conf_file<<"\nMu0_Holes\t=\t"<<config_tct->mu0_holes();
     conf_file<<"\n#saturation velocity cm/s";
     conf_file<<"\nSaturationVelocity\t=\t"<<config_tct->v_sat();
+    conf_file<<"\n#drift velocity model: 0 - Mu0 and SaturationVelocity above, 1 - Canali (saturation at Temperature), 2 - Jacoboni (all at Temperature)";
+    conf_file<<"\nDriftModel\t=\t"<<config_tct->DriftModel();
+    conf_file<<"\n#temperature of the sensor, K";
+    conf_file<<"\nTemperature\t=\t"<<config_tct->Temperature();
     conf_file<<"\n# amplifier amplification";
     conf_file<<"\nAmplification\t=\t"<<config_tct->ampl();
     conf_file<<"\n# factor between charge in sensor and photodiode due to light splitting: Nsensor/Ndiode";
@@ -862,10 +889,18 @@ void base::on_actionFile_Info_triggered()
     }
     char pathandfile[250];
     strcpy(pathandfile,names.at(0).toStdString().c_str());
-    TCTReader *file = new TCTReader(pathandfile,-3,2);
+    // the header is taken from the catalog of the folder if the file is there, otherwise only the header is read
+    std::string info;
+    TCTCatalog catalog(QFileInfo(names.at(0)).absolutePath().toStdString().c_str());
+    int entry = catalog.Load() ? catalog.Find(pathandfile) : -1;
+    if(entry >= 0) info = catalog.StringInfo(entry);
+    else {
+        TCTReader *file = new TCTReader(pathandfile,-3,2,5);
+        info = file->StringInfo();
+        delete file;
+    }
     QMessageBox::about(this, tr("TCT File Info"),
             tr("<h2>File Info</h2>"
                "<b>Name:</b> %1"
-               "<p>%2").arg(names.at(0)).arg(file->StringInfo().c_str()));
-    delete file;
+               "<p>%2").arg(names.at(0)).arg(info.c_str()));
 }
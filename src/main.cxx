@@ -9,6 +9,10 @@
 #include <fstream>
 #include <vector>
 #include <map>
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
 
 //  includes from TCT classes
 #include "sample.h"
@@ -19,6 +23,7 @@
 #include "analysis.h"
 #include "scanning.h"
 #include "tct_config.h"
+#include "TCTCatalog.h"
 
 //  includes from ROOT libraries
 #include "config.h"
@@ -30,6 +35,18 @@
 
 //#define DEBUG
 
+/// Prints the log of a finished file and closes it
+static void PrintLog(const std::string &file, FILE *log, bool ok) {
+    char buf[4096];
+    size_t n;
+    std::cout << "\n  ---- log of " << file << " ----" << std::endl;
+    rewind(log);
+    while((n = fread(buf,1,sizeof(buf),log)) > 0) fwrite(buf,1,n,stdout);
+    fclose(log);
+    if(!ok) std::cout<<"Processing of file "<<file<<" failed. Skipping."<<std::endl;
+    std::cout << "  ---- end of " << file << " ----\n" << std::endl;
+}
+
 int main(int argc, char* argv[])
 {
   std::cout << "\n  This is " << PACKAGE_NAME << " version " << PACKAGE_VERSION << "\n" << std::endl;
@@ -58,6 +75,9 @@ int main(int argc, char* argv[])
       << "   -af <analysis file> (see sample analysis file for example)\n"
       << "   -r <project folder> (e.g. /home/<user>/<my-path>/TCT-analysis/ \n"
       << "   -sa (to save all single acquisition in root file (blows up root file)" // !! needs implementation
+      << "\n   -j <number> (number of .tct files processed at the same time, overrides Threads in analysis file)"
+      << "\n   -catalog <data folder> (update the catalog of the .tct file headers in the folder)"
+      << "\n   -find \"<query>\" (list the .tct files of the catalog matching the query, e.g. \"Sample~X T=300 U>500\")"
       << std::endl;
     return 1;
   }
@@ -65,6 +85,9 @@ int main(int argc, char* argv[])
   TCT::util ana_card;
 
   std::string proj_folder = "def";
+  int jobs = 0;
+  std::string catalog_folder = "def";
+  std::string query = "";
   for (int i = 1; i < argc; i++) {
     if (!strcmp(argv[i],"-r")) {
       proj_folder = argv[++i];
@@ -75,9 +98,25 @@ int main(int argc, char* argv[])
       std::cout << " Try to read analysis file from " << argv[i] << std::endl;
       ana_card.parse(ana_file);
     }
+    if (!strcmp(argv[i],"-j")) jobs = atoi(argv[++i]);
+    if (!strcmp(argv[i],"-catalog")) catalog_folder = argv[++i];
+    if (!strcmp(argv[i],"-find")) query = argv[++i];
     // !! add check for certain vital options, if not passed, break
   }
 
+  if(catalog_folder != "def") {
+    // only the catalog is updated and searched, no analysis is done
+    TCTCatalog catalog(catalog_folder.c_str());
+    int nread = catalog.Update();
+    std::cout << " Catalog of " << catalog_folder << " has " << catalog.GetEntries() << " file(s), " << nread << " header(s) read" << std::endl;
+    if(query != "") {
+      std::vector<int> sel = catalog.Select(query.c_str());
+      std::cout << " " << sel.size() << " file(s) match \"" << query << "\"" << std::endl;
+      for(auto i : sel) catalog.Print(i);
+    }
+    return 0;
+  }
+
   for( auto i : ana_card.ID_val()){
     if(i.first == "ProjectFolder") {
       if(proj_folder != "def") std::cout << " Project folder from command line overwritten by value from analysis card. " << std:: endl;
@@ -229,13 +268,18 @@ int main(int argc, char* argv[])
           // create measurement object from one subdir for each cycle
           TCT::measurement meas(pathndirs[counter]);
 
-          if(!meas.AcqsLoader(&AllAcqs, ana.MaxAcqs(),ana.LeCroyRAW())) {
+          // the acquisitions are read and analysed in blocks of StreamAcqs and dropped afterwards,
+          // only the ones written with SaveSingles are kept (in Singles)
+          uint32_t Nacqs = meas.AcqsLister(ana.MaxAcqs(),ana.LeCroyRAW());
+          uint32_t block = ana.StreamAcqs() > 0 ? ana.StreamAcqs() : Nacqs;
+          if(Nacqs == 0 || !meas.AcqsBlockLoader(&AllAcqs, 0, block, ana.LeCroyRAW())) {
               std::cout << " Folder empty! Skipping folder" << std::endl;
               counter++;
               if( countersubdir == 0) break;
               if(counter == countersubdir) break;
               continue;
           };
+          std::vector<TCT::acquisition_single> Singles;
 
           // now create instance of avg acquisition using Nsamples from loaded files
           TCT::acquisition_avg AcqAvg(AllAcqs[0].Nsamples());
@@ -245,33 +289,14 @@ int main(int argc, char* argv[])
           int Nselected = 0;
 
 #ifdef DEBUG
-          std::cout << "Size of AllAcqs = " << AllAcqs.size() << std::endl;
-#endif
-
-          AcqAvg.SetNanalysed(AllAcqs.size());
-          for(uint32_t i_acq = 0; i_acq < AllAcqs.size(); i_acq++){
-
-#ifdef DEBUG
-              std::cout << " - Start with Acq #" << i_acq << std::endl;
-#endif
-
-              TCT::acquisition_single* acq = &AllAcqs[i_acq];
-              if(ana.DoSmearing()) ana.AcqsSmearer(acq, ana.AddNoise(), false);
-              ana.AcqsAnalyser(acq, i_acq, &AcqAvg);
-              if(ana.DoSmearing()) ana.AcqsSmearer(acq, false, ana.AddJitter()); // AcqsAnalyser removes jitter by determining each acqs delay. Hence, to add jitter, delay has to be manipulated after AcqsAnalyser (and before filling of profile
-
-#ifdef DEBUG
-              std::cout << *acq << std::endl;
+          std::cout << "Number of acquisitions = " << Nacqs << ", block size = " << block << std::endl;
 #endif
 
-              if( ana.AcqsSelecter(acq) ) {
-                  Nselected++;
-                  acq->SetSelect(true);
-              }
-              AcqAvg.SetNselected(Nselected);
-              ana.AcqsProfileFiller(acq, &AcqAvg);
-
-          } // end fot AllAcqs.size()
+          AcqAvg.SetNanalysed(Nacqs);
+          for(uint32_t first = 0; first < Nacqs; first += block) {
+              if(first > 0) meas.AcqsBlockLoader(&AllAcqs, first, block, ana.LeCroyRAW());
+              ana.AcqsProcessor(&AllAcqs, first, &AcqAvg, &Nselected, &Singles);
+          }
 
           //std::cout << "Mean s2nval = " << AcqAvg.M_V_S2nval() << std::endl;
 
@@ -286,24 +311,24 @@ int main(int argc, char* argv[])
 
 
           if(ana.SaveToFile())
-              if(countersubdir > 0) ana.AcqsWriter(&AllAcqs, &AcqAvg, true);
-              else ana.AcqsWriter(&AllAcqs, &AcqAvg, false);
+              if(countersubdir > 0) ana.AcqsWriter(&Singles, &AcqAvg, true);
+              else ana.AcqsWriter(&Singles, &AcqAvg, false);
 
           std::cout << "   Nselected = " << Nselected << std::endl;
-          std::cout << "   ratio of selected acqs = " << Nselected << " / " << AllAcqs.size() << " = " << (float)Nselected/AllAcqs.size()*100. << "%\n\n" << std::endl;
+          std::cout << "   ratio of selected acqs = " << Nselected << " / " << Nacqs << " = " << (float)Nselected/Nacqs*100. << "%\n\n" << std::endl;
 
           // now take care of memory management
-          // delete remaning TH1Fs in acquisition_single and then clear AllAcqs
-          for(int j = 0; j < AllAcqs.size(); j++) {
-              AllAcqs[j].Clear();
+          // delete remaning TH1Fs of the kept acquisitions and then clear Singles
+          for(int j = 0; j < Singles.size(); j++) {
+              Singles[j].Clear();
           }
-          AllAcqs.clear();
+          Singles.clear();
 
           counter++;
           if( countersubdir == 0) break;
           if(counter == countersubdir) break;
 #ifdef DEBUG
-          std::cout << "   AllAcqs has " << AllAcqs.size() << " objects left" << std::endl;
+          std::cout << "   Singles has " << Singles.size() << " objects left" << std::endl;
 #endif
 
       }
@@ -345,21 +370,78 @@ int main(int argc, char* argv[])
           daq_data.SimulateDoFocus(f_rootfile_1,&config);
           f_rootfile_1->Close();
       */
+      if(jobs > 0) config.SetThreads(jobs);
+#ifdef _WIN32
+      config.SetThreads(1);
+#endif
+
       const char *infile;
+      std::vector<std::string> files;
       while((infile = gSystem->GetDirEntry(dirp))) {
+          if (strstr(infile,".tct")) files.push_back(config.DataFolder() + infile);
+      }
 
-          if (strstr(infile,".tct")) {
+      if(config.Threads() <= 1) {
+          // the next file is read and corrected while the modules work on the current one
+          TCT::Prefetch prefetch;
+          for(uint32_t i = 0; i < files.size(); i++) {
+              TCTReader *reader;
+              ULong64_t hash = prefetch.Wait(files[i],&reader);
+              if(i+1 < files.size()) prefetch.Start(files[i+1],&config);
               char pathandfile[250];
-              strcpy(pathandfile,config.DataFolder().c_str());
-              strcat(pathandfile,infile);
+              strcpy(pathandfile,files[i].c_str());
               std::cout << "  read file from: " << pathandfile << std::endl;
 
               TCT::Scanning daq_data;
-              bool read = daq_data.ReadTCT(pathandfile,&config);
+              bool read = daq_data.ReadTCT(pathandfile,&config,hash,reader);
               if(!read) {std::cout<<"Processing of file "<<pathandfile<<" failed. Skipping."<<std::endl;  continue;}
           }
-
       }
+#ifndef _WIN32
+      else {
+          // Every file is processed by its own process, so ROOT, the modules and the output
+          // files are never shared. The output of a file is kept in a temporary log and
+          // printed at once when the file is finished.
+          std::map<pid_t, std::pair<std::string, FILE*> > running;
+          uint32_t next = 0;
+          std::cout << "  processing " << files.size() << " files, " << config.Threads() << " at a time" << std::endl;
+          while(next < files.size() || running.size() > 0) {
+              if(next < files.size() && running.size() < config.Threads()) {
+                  FILE *log = tmpfile();
+                  std::cout.flush(); fflush(stdout);
+                  pid_t pid = log ? fork() : -1;
+                  if(pid == 0) {
+                      dup2(fileno(log),fileno(stdout));
+                      dup2(fileno(log),fileno(stderr));
+                      char pathandfile[250];
+                      strcpy(pathandfile,files[next].c_str());
+                      std::cout << "  read file from: " << pathandfile << std::endl;
+                      TCT::Scanning daq_data;
+                      bool read = daq_data.ReadTCT(pathandfile,&config);
+                      std::cout.flush(); fflush(stdout);
+                      _exit(read ? 0 : 1);
+                  }
+                  if(pid < 0) {
+                      std::cout << "   *** Could not start the processing of " << files[next] << ", processing it here" << std::endl;
+                      if(log) fclose(log);
+                      char pathandfile[250];
+                      strcpy(pathandfile,files[next].c_str());
+                      TCT::Scanning daq_data;
+                      if(!daq_data.ReadTCT(pathandfile,&config)) std::cout<<"Processing of file "<<pathandfile<<" failed. Skipping."<<std::endl;
+                  }
+                  else running[pid] = std::make_pair(files[next],log);
+                  next++;
+                  continue;
+              }
+              int status;
+              pid_t pid = wait(&status);
+              if(pid < 0) break;
+              if(running.count(pid) == 0) continue;
+              PrintLog(running[pid].first,running[pid].second,WIFEXITED(status) && WEXITSTATUS(status) == 0);
+              running.erase(pid);
+          }
+      }
+#endif
   }
 
   //theApp.Run(kTRUE); 
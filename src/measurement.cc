@@ -5,8 +5,14 @@
 
 #include<string>
 #include <list>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <cstring>
 
 #include "measurement.h"
+#include "util.h"
 //#include "acquisition.h"
 
 //  includes from ROOT libraries
@@ -15,13 +21,21 @@
 
 namespace TCT {
 
-  bool measurement::AcqsLoader(std::vector<TCT::acquisition_single> *allAcqs, uint32_t MaxAcqs, bool LeCroyRAW){
+  bool measurement::AcqsLoader(std::vector<TCT::acquisition_single> *allAcqs, uint32_t MaxAcqs, bool LeCroyRAW, uint32_t nthreads){
+
+    uint32_t nfiles = AcqsLister(MaxAcqs, LeCroyRAW);
+    if(nfiles == 0) return false;
+    return AcqsBlockLoader(allAcqs, 0, nfiles, LeCroyRAW, nthreads);
+  } // end of LoadAcqs()
+
+  uint32_t measurement::AcqsLister(uint32_t MaxAcqs, bool LeCroyRAW){
 
     //if(debug) std::cout << "start PulseCheck" << std::endl;
 
+    _Files.clear();
     if(MaxAcqs == 0) {
       std::cout << "MaxAcqs is zero, stopping " << std::endl;
-      return false;
+      return 0;
     }
     if(MaxAcqs == -1) {
       std::cout << "MaxAcqs is -1, reading all files " << std::endl;
@@ -37,72 +51,82 @@ namespace TCT {
     //if (!AllTests) Init();
     //GetCuts(filedir);
 
-    // get list of files in filedir
+    // get list of files in filedir, the directory is listed once and the files are
+    // taken in the order of their names (numbers in the names compared as numbers)
     void *dir = gSystem->OpenDirectory(filedir);
     const char *infile;
-    uint32_t nfiles = 0;
-    //std::cout << "do read in" << std::endl;
-    //char key = getchar();
-    std::cout<<"Parsing oscilloscope data"<<std::endl;
-    if(LeCroyRAW) {
-        std::cout << " Parsing data using LeCroy RAW reader " << std::endl;
-        while((infile = gSystem->GetDirEntry(dir))) {
-            if (strstr(infile,".trc")) {
-                char pathandfile[250];
-                strcpy(pathandfile,filedir);
-                strcat(pathandfile,infile);
-                if(nfiles < 3) std::cout << "  read file from: " << pathandfile << std::endl;
-                if(nfiles == 3) std::cout << " suppressing further 'read from' info" << std::endl;
-
-                TCT::acquisition_single acq(nfiles);
-                std::string fullfname = pathandfile;
-                bool read = acq.ReadRAW(fullfname, nfiles);
-                nfiles++;
-                //std::cout << "nfiles: " << nfiles;
-                allAcqs->push_back(acq);
-                if (nfiles > MaxAcqs-1) break;
-            }
-        }
+    while((infile = gSystem->GetDirEntry(dir))) {
+        if(LeCroyRAW && strstr(infile,".trc")) _Files.push_back(infile);
+        if(!LeCroyRAW && strstr(infile,".txt") && !strstr(infile,".swp")) _Files.push_back(infile);
     }
-    else {
-        std::cout << " Parsing data using *.txt reader " << std::endl;
-        FILE *file;
-        while((infile = gSystem->GetDirEntry(dir))) {
-            if (strstr(infile,".txt") && !strstr(infile,".swp") ) {
-                char pathandfile[250];
-                strcpy(pathandfile,filedir);
-                strcat(pathandfile,infile);
-                if(nfiles < 3) std::cout << "  read file from: " << pathandfile << std::endl;
-                if(nfiles == 3) std::cout << " suppressing further 'read from' info" << std::endl;
-                file = fopen(pathandfile,"r");
-                if (!file) {
-                    std::cout << "   *** Can't open file! Exiting!" <<std::endl;
-                    exit(1);
-                }
-
-                TCT::acquisition_single acq(nfiles);
-                bool read = acq.Read(file, nfiles);
-                fclose(file);
-                nfiles++;
-                //std::cout << "nfiles: " << nfiles;
-                allAcqs->push_back(acq);
-                if (nfiles > MaxAcqs-1) break;
-            }
-        }
+    gSystem->FreeDirectory(dir);
+    std::sort(_Files.begin(),_Files.end(),NaturalLess);
+    if(_Files.size() > MaxAcqs) _Files.resize(MaxAcqs);
+
+    if(_Files.size() == 0) { 
+      std::cout << " -> no files read " << std::endl;
+    } else {
+      std::cout << "   -> Found " << _Files.size() << " acquisitions, proceed with analysis" <<std::endl;
     }
 
-    gSystem->FreeDirectory(dir);
+    return _Files.size();
+  } // end of AcqsLister()
 
+  bool measurement::AcqsBlockLoader(std::vector<TCT::acquisition_single> *allAcqs, uint32_t first, uint32_t n, bool LeCroyRAW, uint32_t nthreads){
 
+    const char* filedir = _DataInFolder.c_str();
+    if(first >= _Files.size()) return false;
+    if(n > _Files.size()-first) n = _Files.size()-first;
+    const std::string *files = &_Files[first];
 
-    if(nfiles == 0) { 
-      std::cout << " -> no files read " << std::endl; return false;
-    } else {
-      std::cout << "   -> Found " << allAcqs->size() << " acquisitions, proceed with analysis" <<std::endl;
+    if(first == 0) {
+      std::cout<<"Parsing oscilloscope data"<<std::endl;
+      if(LeCroyRAW) std::cout << " Parsing data using LeCroy RAW reader " << std::endl;
+      else std::cout << " Parsing data using *.txt reader " << std::endl;
+      for(uint32_t i=0; i<n && i<3; i++) std::cout << "  read file from: " << filedir << files[i] << std::endl;
+      if(_Files.size() > 3) std::cout << " suppressing further 'read from' info" << std::endl;
+    }
+
+    // the files are parsed on worker threads into their slots of allAcqs, the histograms
+    // (ROOT objects) are made afterwards in this thread
+    size_t start = allAcqs->size();
+    allAcqs->reserve(start+n);
+    for(uint32_t i=0; i<n; i++) allAcqs->push_back(TCT::acquisition_single(first+i));
+
+    std::vector<int> status(n,0); // 0 - parsed, 1 - can't open, 2 - read error
+    std::atomic<uint32_t> next(0);
+    auto worker = [&]() {
+        for(uint32_t i=next++; i<n; i=next++) {
+            std::string pathandfile = std::string(filedir)+files[i];
+            TCT::acquisition_single &acq = allAcqs->at(start+i);
+            if(LeCroyRAW) {
+                if(!acq.ParseRAW(pathandfile)) status[i] = 2;
+                continue;
+            }
+            FILE *file = fopen(pathandfile.c_str(),"r");
+            if (!file) { status[i] = 1; continue; }
+            if(!acq.Parse(file)) status[i] = 2;
+            fclose(file);
+        }
+    };
+    if(nthreads == 0) nthreads = std::thread::hardware_concurrency();
+    if(nthreads > n) nthreads = n;
+    std::vector<std::thread> pool;
+    for(uint32_t t=1; t<nthreads; t++) pool.push_back(std::thread(worker));
+    worker();
+    for(uint32_t t=0; t<pool.size(); t++) pool[t].join();
+
+    for(uint32_t i=0; i<n; i++) {
+        if(status[i] == 1 || (status[i] == 2 && !LeCroyRAW)) {
+            std::cout << "  file: " << filedir << files[i] << std::endl;
+            if(status[i] == 1) std::cout << "   *** Can't open file! Exiting!" <<std::endl;
+            exit(1);
+        }
+        if(status[i] == 0) allAcqs->at(start+i).MakeHistograms(first+i);
     }
 
     return true;
-  } // end of LoadAcqs()
+  } // end of AcqsBlockLoader()
 
 
 }
@@ -49,9 +49,6 @@ bool ModuleDoubleChannelAnalysis::Analysis() {
 
     int TotalNPoints = nVolts1*nVolts2*NumScanAxis2*NumOptAxis;
 
-    TCTWaveform **wf1 = new TCTWaveform*[TotalNPoints];
-    TCTWaveform **wf2 = new TCTWaveform*[TotalNPoints];
-
     TGraph **charges1 = new TGraph*[TotalNPoints];
     TGraph **charges2 = new TGraph*[TotalNPoints];
     std::string str[TotalNPoints];
@@ -62,16 +59,14 @@ bool ModuleDoubleChannelAnalysis::Analysis() {
             for(int m = 0; m < NumScanAxis2; m++) {
                for(int i = 0; i < nVolts1; i++) {
                    for(int j = 0; j < nVolts2; j++) {
-                       wf1[k] = stct->Projection(Ch1Number,scanning_axis1,0,m,n,i,j,NumScanAxis1);
                        //std::cout << stct->GetHA(Ch2Number,0,m,n,i,j)->GetTitle() << std::endl;
                        std::ostringstream outp;
                        outp << stct->GetHA(Ch2Number,0,m,n,i,j)->GetTitle();
                        str[k]= outp.str().c_str() ;
                        std::size_t pos = str[k].find("y=");
                        str[k] = str[k].substr (pos);
-                       charges1[k]=wf1[k]->CCE(config->FTlowCH1(),config->FThighCH1());   //integrate the charge in time window
-                       wf2[k] = stct->Projection(Ch2Number,scanning_axis1,0,m,n,i,j,NumScanAxis1);
-                       charges2[k]=wf2[k]->CCE(config->FTlowCH2(),config->FThighCH2());   //integrate the charge in time window
+                       charges1[k]=ChargeProfile(stct->View(Ch1Number,scanning_axis1,0,m,n,i,j,NumScanAxis1),config->FTlowCH1(),config->FThighCH1());   //integrate the charge in time window
+                       charges2[k]=ChargeProfile(stct->View(Ch2Number,scanning_axis1,0,m,n,i,j,NumScanAxis1),config->FTlowCH2(),config->FThighCH2());   //integrate the charge in time window
                        k++;
                    }
                }
@@ -82,16 +77,14 @@ bool ModuleDoubleChannelAnalysis::Analysis() {
             for(int m = 0; m < NumScanAxis2; m++) {
                for(int i = 0; i < nVolts1; i++) {
                    for(int j = 0; j < nVolts2; j++) {
-                       wf1[k] = stct->Projection(Ch1Number,scanning_axis1,m,0,n,i,j,NumScanAxis1);
                        //std::cout << stct->GetHA(Ch2Number,0,m,n,i,j)->GetTitle() << std::endl;
                        std::ostringstream outp;
                        outp << stct->GetHA(Ch2Number,m,0,n,i,j)->GetTitle();
                        str[k]= outp.str().c_str() ;
                        std::size_t pos = str[k].find("y=");
                        str[k] = str[k].substr (pos);
-                       charges1[k]=wf1[k]->CCE(config->FTlowCH1(),config->FThighCH1());   //integrate the charge in time window
-                       wf2[k] = stct->Projection(Ch2Number,scanning_axis1,m,0,n,i,j,NumScanAxis1);
-                       charges2[k]=wf2[k]->CCE(config->FTlowCH2(),config->FThighCH2());   //integrate the charge in time window
+                       charges1[k]=ChargeProfile(stct->View(Ch1Number,scanning_axis1,m,0,n,i,j,NumScanAxis1),config->FTlowCH1(),config->FThighCH1());   //integrate the charge in time window
+                       charges2[k]=ChargeProfile(stct->View(Ch2Number,scanning_axis1,m,0,n,i,j,NumScanAxis1),config->FTlowCH2(),config->FThighCH2());   //integrate the charge in time window
                        k++;
                    }
                }
@@ -102,16 +95,14 @@ bool ModuleDoubleChannelAnalysis::Analysis() {
             for(int m = 0; m < NumScanAxis2; m++) {
                for(int i = 0; i < nVolts1; i++) {
                    for(int j = 0; j < nVolts2; j++) {
-                       wf1[k] = stct->Projection(Ch1Number,scanning_axis1,n,m,0,i,j,NumScanAxis1);
                        //std::cout << stct->GetHA(Ch2Number,0,m,n,i,j)->GetTitle() << std::endl;
                        std::ostringstream outp;
                        outp << stct->GetHA(Ch2Number,n,m,0,i,j)->GetTitle();
                        str[k]= outp.str().c_str() ;
                        std::size_t pos = str[k].find("y=");
                        str[k] = str[k].substr (pos);
-                       charges1[k]=wf1[k]->CCE(config->FTlowCH1(),config->FThighCH1());   //integrate the charge in time window
-                       wf2[k] = stct->Projection(Ch2Number,scanning_axis1,n,m,0,i,j,NumScanAxis1);
-                       charges2[k]=wf2[k]->CCE(config->FTlowCH2(),config->FThighCH2());   //integrate the charge in time window
+                       charges1[k]=ChargeProfile(stct->View(Ch1Number,scanning_axis1,n,m,0,i,j,NumScanAxis1),config->FTlowCH1(),config->FThighCH1());   //integrate the charge in time window
+                       charges2[k]=ChargeProfile(stct->View(Ch2Number,scanning_axis1,n,m,0,i,j,NumScanAxis1),config->FTlowCH2(),config->FThighCH2());   //integrate the charge in time window
                        k++;
                    }
                }
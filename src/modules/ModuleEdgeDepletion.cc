@@ -67,9 +67,8 @@ bool ModuleEdgeDepletion::Analysis() {
 
 
     //std::cout<<"charge left: "<<charge_left<<" charge right: "<<charge_right<<std::endl;
-    for(int j=0;j<numVolt;j++) {
-        total_charge[j] = GraphIntegral(cc[j],left_edge,right_edge);
-    }
+    //the voltages are independent, the integrals are taken in parallel when the profiles are long
+    ParallelFor(numVolt,[&](Int_t j) { total_charge[j] = GraphIntegral(cc[j],left_edge,right_edge); },numS);
     if(total_charge[numVolt-1]<0) {
         for(int j=0;j<numVolt;j++) total_charge[j]=-total_charge[j];
     }
@@ -88,9 +87,7 @@ bool ModuleEdgeDepletion::Analysis() {
         }
 
 
-        for(int j=0;j<numVolt;j++) {
-            total_charge_normed[j] = GraphIntegral(cc_norm[j],left_edge,right_edge);
-        }
+        ParallelFor(numVolt,[&](Int_t j) { total_charge_normed[j] = GraphIntegral(cc_norm[j],left_edge,right_edge); },numS);
         if(total_charge_normed[numVolt-1]<0) {
             for(int j=0;j<numVolt;j++) total_charge_normed[j]=-total_charge_normed[j];
         }
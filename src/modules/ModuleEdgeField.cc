@@ -4,6 +4,7 @@
  */
 
 #include "modules/ModuleEdgeField.h"
+#include "TCTField.h"
 #include "TStyle.h"
 
 #ifdef USE_GUI
@@ -66,14 +67,12 @@ bool ModuleEdgeField::Analysis() {
 
     //find integration ranges (for the maximal voltage in scan, hope that sensor is fully depleted
     //otherwise may be a problem with right edge
-    TCTWaveform *wf0;
-    switch(volt_source)
-      {
-      case 1: wf0 = stct->Projection(ChNumber,scanning_axis,0,0,0,numVolt-1,0,numS); break;
-      case 2: wf0 = stct->Projection(ChNumber,scanning_axis,0,0,0,0,numVolt-1,numS); break;
-      }
-    TGraph *charge_max_bias = wf0->CCE(config->FTlowCH1(),config->FThighCH1());
-    delete wf0;
+    //the charge map of the full window is shared with the other edge modules
+    TGraph **cc_full = new TGraph*[numVolt];
+    CalculateCharges(ChNumber,volt_source+2,numVolt,scanning_axis,numS,cc_full,config->FTlowCH1(),config->FThighCH1());
+    TGraph *charge_max_bias = cc_full[numVolt-1];
+    for(int j=0;j<numVolt-1;j++) delete cc_full[j];
+    delete [] cc_full;
     Double_t left_edge,right_edge;
     FindEdges(charge_max_bias,numS,Ss,left_edge,right_edge);
     std::cout<<std::endl;
@@ -98,34 +97,37 @@ bool ModuleEdgeField::Analysis() {
     if(config->CH_PhDiode()) CalculateCharges(config->CH_PhDiode()-1,volt_source+2,numVolt,scanning_axis,numS,ph_charge,config->FDLow(),config->FDHigh());
 
     //calculating the velocity profile asuuming integral(E)dx = Vbias
+    //the voltages are independent: the field and velocity profiles are solved by ParallelFor
+    //into plain arrays, the graphs are built afterwards in the main thread, in order
     Double_t eps = 1e-3;
-    Double_t *temp_sensor;
-    Double_t *temp_vel_h=new Double_t[numS];
-    Double_t *temp_vel_el=new Double_t[numS];
-    Double_t *temp_field=new Double_t[numS];
+    Double_t *temp_field, *temp_vel_h, *temp_vel_el;
+    std::vector<Double_t> fields((Long64_t)numVolt*numS);
+    std::vector<Double_t> vel_h((Long64_t)numVolt*numS);
+    std::vector<Double_t> vel_el((Long64_t)numVolt*numS);
+    std::vector<Double_t> norm(numVolt);
+    std::vector<char> reached(numVolt);
+    DriftModel drift(config);
+    std::cout<<"Drift model: "<<DriftModel::ModelName(config->DriftModel())<<std::endl;
+    TGraph **charges;
+    auto solve=[&](Int_t j) {
+        Double_t *f = &fields[(Long64_t)j*numS];
+        norm[j] = 1;
+        if(GraphIntegral(charges[j],left_edge,right_edge)<0) norm[j] = -1;
+        reached[j] = Normalisation(drift,abs(voltages[j]),numS,charges[j]->GetY(),ix1,ix2,Ss,norm[j],eps,f);
+        // velocities of the same model that was used for the field, V/cm -> V/um afterwards
+        drift.Velocity(numS,f,DriftModel::kHole,&vel_h[(Long64_t)j*numS]);
+        drift.Velocity(numS,f,DriftModel::kElectron,&vel_el[(Long64_t)j*numS]);
+        for(int i=0;i<numS;i++) f[i] = 1e-4*f[i];
+    };
+    charges = cc;
+    ParallelFor(numVolt,solve);
     for(int j=0;j<numVolt;j++) { // FIXME constants seems to prefer smaller values towards low electric fields , why?
-        temp_sensor = cc[j]->GetY();
-        Double_t a=1;
-        if(GraphIntegral(cc[j],left_edge,right_edge)<0) a = -a;
-        Double_t dx = 0.5*a;
-        Double_t sum = 0;
-        while(abs(abs(voltages[j])-sum)>eps) {
-            for(int i=0; i<numS; i++) {
-                temp_field[i] = BiSectionMethod(eps,-5e3,1e6,temp_sensor[i],a);
-            }
-            sum=0;
-            for(int i=ix1;i<=ix2;i++) sum+=temp_field[i];
-            sum*=1e-4*Ss; // conversion from um to cm
-            if(abs(voltages[j])-sum>0) a-=dx;
-            else a+=dx;
-            dx=dx/2;
-        }
+        Double_t a = norm[j];
+        temp_field = &fields[(Long64_t)j*numS];
+        temp_vel_h = &vel_h[(Long64_t)j*numS];
+        temp_vel_el = &vel_el[(Long64_t)j*numS];
+        if(!reached[j]) std::cout<<"Warning: no normalisation constant for U = "<<abs(voltages[j])<<std::endl;
         std::cout<<"U = "<<voltages[j]<<" norm const: "<<a<<std::endl;
-        for(int i=0;i<numS;i++) {
-            temp_field[i] = 1e-4*temp_field[i];
-            temp_vel_h[i] = 1e4*temp_field[i]*Mu(temp_field[i],1)/(1+Mu(temp_field[i],1)*1e4*temp_field[i]/config->v_sat());
-            temp_vel_el[i] = 1e4*temp_field[i]*Mu(temp_field[i],0)/(1+Mu(temp_field[i],0)*1e4*temp_field[i]/config->v_sat());
-        }
         // building of the graphs
         field[j] = GraphBuilder(numS,cc[0]->GetX(),temp_field,"scanning distance [#mum]", "Electric Field, [V/#mum]","Electric Field");
         velocity_holes[j] = GraphBuilder(numS,cc[0]->GetX(),temp_vel_h,"scanning distance [#mum]", "Velocity [cm/s]","Holes Velocity Profile");
@@ -139,34 +141,16 @@ bool ModuleEdgeField::Analysis() {
         //calculating the mean charge from the photodetector
         cc_norm=NormedCharge(cc,ph_charge,numVolt);
 
-        Double_t *temp_sensor;
-
+        charges = cc_norm;
+        ParallelFor(numVolt,solve);
         for(int j=0;j<numVolt;j++) {
-            temp_sensor = cc_norm[j]->GetY();
-            Double_t a=1;
-            if(GraphIntegral(cc_norm[j],left_edge,right_edge)<0) a = -a;
-            Double_t dx = 0.5*a;
-            Double_t sum = 0;
-            /*while(abs(abs(voltages[j])-sum)>eps) {
-
-                for(int i=0; i<numS; i++) {
-                    temp_field[i] = BiSectionMethod(eps,-5e3,1e6,temp_sensor[i],a);
-                }
-                sum=0;
-                for(int i=ix1;i<=ix2;i++) sum+=temp_field[i];
-                sum*=1e-4*Ss;
-                if(abs(voltages[j])-sum>0) a-=dx;
-                else a+=dx;
-                dx=dx/2;
-            }*/
-            if(GraphIntegral(cc_norm[j],left_edge,right_edge)<0) normcoeff[j]=-a;
-            else normcoeff[j]=a;
+            Double_t a = norm[j];
+            temp_field = &fields[(Long64_t)j*numS];
+            temp_vel_h = &vel_h[(Long64_t)j*numS];
+            temp_vel_el = &vel_el[(Long64_t)j*numS];
+            normcoeff[j] = abs(a);
+            if(!reached[j]) std::cout<<"Warning: no normalisation constant for U = "<<abs(voltages[j])<<std::endl;
             //std::cout<<"U = "<<voltages[j]<<" norm const: "<<a<<std::endl;
-            for(int i=0;i<numS;i++) {
-                temp_field[i] = 1e-4*temp_field[i];
-                temp_vel_h[i] = 1e4*temp_field[i]*Mu(temp_field[i],1)/(1+Mu(temp_field[i],1)*1e4*temp_field[i]/config->v_sat());
-                temp_vel_el[i] = 1e4*temp_field[i]*Mu(temp_field[i],0)/(1+Mu(temp_field[i],0)*1e4*temp_field[i]/config->v_sat());
-            }
             field_normed[j] = GraphBuilder(numS,cc[0]->GetX(),temp_field,"scanning distance [#mum]", "Electric Field, [V/#mum]","Electric Field");
             velocity_holes_normed[j] = GraphBuilder(numS,cc[0]->GetX(),temp_vel_h,"scanning distance [#mum]", "Velocity [cm/s]","Holes Velocity Profile");
             velocity_electrons_normed[j] = GraphBuilder(numS,cc[0]->GetX(),temp_vel_el,"scanning distance [#mum]", "Velocity [cm/s]","Electrons Velocity Profile");
@@ -174,10 +158,6 @@ bool ModuleEdgeField::Analysis() {
         }
     }
 
-    delete temp_vel_h;
-    delete temp_vel_el;
-    delete temp_field;
-
 
     //calculating the velocity profile using photodiode for estimate of N_e,h, Factor 100 to many :(
     if(config->CH_PhDiode()) {
@@ -352,47 +332,4 @@ void ModuleEdgeField::ToVariables() {
 
 #endif
 
-/// Mobility with energy
-Double_t ModuleEdgeField::Mu(Double_t E, Int_t Type) {
-
-    /** \param[in] E Energy
-         *  \param[in] type Charge carrier type. 1 - hole, 0 - electron.
-          */
-
-    if(Type==1) return config->mu0_holes()/(1.+config->mu0_holes()*E/config->v_sat());
-    if(Type==0) return config->mu0_els()/sqrt(1.+config->mu0_els()*E/config->v_sat()*config->mu0_els()*E/config->v_sat());
-    else return 0;
 }
-
-/// Function used in the bisection method
-Double_t ModuleEdgeField::ff(Double_t E, Double_t Uuu, Double_t a) {
-    /**   Based on formula \f$U = A*(\mu_{els}+\mu_{holes})*E\f$.
-         *    Where U - measured charge, E - electric field.
-          */
-    return Uuu-a*(Mu(E,1)+Mu(E,0))*E;
-}
-
-/// Implements bisection method for solving the equation
-Double_t ModuleEdgeField::BiSectionMethod(Double_t eps, Double_t x1, Double_t x2, Double_t Uuu, Double_t a) {
-    if(ff(x1,Uuu,a)==0) return x1;
-    if(ff(x2,Uuu,a)==0) return x2;
-    Double_t dx = x2-x1;
-    Double_t xi;
-    while(abs(ff(xi,Uuu,a))>eps) {
-        dx = dx/2;
-        xi = x1+dx;
-        if(sgn(ff(x1,Uuu,a))!=sgn(ff(xi,Uuu,a))) continue;
-        else x1=xi;
-    }
-    //std::cout<<"x = "<<xi<<" Fe = "<<ff(xi,Uuu,a)<<std::endl;
-    return xi;
-}
-
-/// Sgn implementation
-template <typename T> int ModuleEdgeField::sgn(T val) {
-    return (T(0) < val) - (val < T(0));
-}
-
-}
-
-
@@ -70,6 +70,11 @@ bool ModuleTopFocus::Analysis() {
     Int_t i_max, i_min;
     Float_t max, min;
 
+    // with FitContinuation the fit of each position starts from the previous solution
+    Double_t prev[4];
+    Bool_t prev_ok = false;
+    FitCount count;
+
     for(int j=0;j<numO;j++){
 
         yy_temp = cc[j]->GetY();
@@ -89,7 +94,13 @@ bool ModuleTopFocus::Analysis() {
 
         SetFitParameters(ff2,i_min*Ss,FWHM,max,FWHM);
 
-        cc[j]->Fit("ff2","Rq");
+        if(config->FitContinuation()) {
+            prev_ok = FitStep(cc[j],ff2,StripModel(),prev_ok ? prev : NULL,&count);
+            for(int i=0;i<4;i++) prev[i] = ff2->GetParameter(i);
+            StoreFunction(cc[j],ff2,false);
+        }
+        else if(config->FastFit()) FitGraph(cc[j],ff2,StripModel(),true);
+        else cc[j]->Fit("ff2","Rq");
         gStyle->SetOptFit(1);
         width[j]=ff2->GetParameter(1)*2.35/TMath::Sqrt(2);
         pos[j]=ff2->GetParameter(0)+ ff2->GetParameter(3)/2;
@@ -97,12 +108,15 @@ bool ModuleTopFocus::Analysis() {
         strip_w[j] = ff2->GetParameter(3);
         optical_axis_co[j]=Opt0+j*Os;
     }
+    if(config->FitContinuation()) PrintFitCount(count,"Strip fits");
 
 
     //calculating the normed charge distribution
     if(config->CH_PhDiode()) {
 
         cc_norm = NormedCharge(cc,ph_charge,numO);
+        prev_ok = false;
+        count = FitCount();
 
         for(int j=0;j<numO;j++) {
             yy_temp = cc_norm[j]->GetY();
@@ -121,7 +135,13 @@ bool ModuleTopFocus::Analysis() {
             }
             SetFitParameters(ff2,i_min*Ss,FWHM,max,FWHM);
 
-            cc_norm[j]->Fit("ff2","Rq");
+            if(config->FitContinuation()) {
+                prev_ok = FitStep(cc_norm[j],ff2,StripModel(),prev_ok ? prev : NULL,&count);
+                for(int i=0;i<4;i++) prev[i] = ff2->GetParameter(i);
+                StoreFunction(cc_norm[j],ff2,false);
+            }
+            else if(config->FastFit()) FitGraph(cc_norm[j],ff2,StripModel(),true);
+            else cc_norm[j]->Fit("ff2","Rq");
             gStyle->SetOptFit(1);
 
             width_normed[j]=ff2->GetParameter(1)*2.35/TMath::Sqrt(2);
@@ -129,6 +149,7 @@ bool ModuleTopFocus::Analysis() {
             minQ_normed[j] = ff2->Eval(ff2->GetParameter(0) + ff2->GetParameter(3)/2)/ff2->GetParameter(2);
             strip_w_normed[j] = ff2->GetParameter(3);
         }
+        if(config->FitContinuation()) PrintFitCount(count,"Strip fits (normed)");
     }
 
     if(config->FSeparateCharges()) {
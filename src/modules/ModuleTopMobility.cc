@@ -4,6 +4,7 @@
  */
 
 #include "modules/ModuleTopMobility.h"
+#include "TCTDrift.h"
 #include "TStyle.h"
 
 namespace TCT {
@@ -58,10 +59,16 @@ bool ModuleTopMobility::Analysis() {
 
     TGraph* velocity_plot = GraphBuilder(numVolt,field,speed,"Electric Field, [V/cm]","Speed, [cm/s]","Charge Carrier Speed vs Electric Field");
 
-    TF1 *mobility_fit = new TF1("mobility_fit","[0]*x/(1.0+[0]*x/[1])");
-    mobility_fit->FixParameter(1,config->v_sat());
+    //the low field mobility is fitted with the hole velocity of the drift model of the configuration,
+    //the saturation velocity and beta of the model are fixed
+    DriftModel drift(config);
+    TF1 *mobility_fit = new TF1("mobility_fit",DriftModel::Formula());
+    mobility_fit->SetParameter(0,drift.Mu0(DriftModel::kHole));
+    mobility_fit->FixParameter(1,drift.Vsat(DriftModel::kHole));
+    mobility_fit->FixParameter(2,drift.Beta(DriftModel::kHole));
     mobility_fit->SetParName(0,"Mobility");
     mobility_fit->SetParName(1,"V_sat");
+    mobility_fit->SetParName(2,"Beta");
     mobility_fit->SetRange(velocity_plot->GetHistogram()->GetBinCenter(1),velocity_plot->GetHistogram()->GetBinCenter(velocity_plot->GetHistogram()->GetNbinsX()-1));
 
 
@@ -69,8 +76,19 @@ bool ModuleTopMobility::Analysis() {
     gStyle->SetOptFit(1);
     velocity_plot->Write("VelocityVsField");
 
+    //velocities of the drift model of the configuration at the same fields, for comparison
+    Double_t *efield = new Double_t[numVolt];
+    Double_t *vmodel = new Double_t[numVolt];
+    for(int i=0;i<numVolt;i++) efield[i] = field[i];
+    drift.Velocity(numVolt,efield,DriftModel::kHole,vmodel);
+    GraphBuilder(numVolt,efield,vmodel,"Electric Field, [V/cm]","Speed, [cm/s]","Holes Velocity of the Drift Model","VelocityModel_Holes");
+    drift.Velocity(numVolt,efield,DriftModel::kElectron,vmodel);
+    GraphBuilder(numVolt,efield,vmodel,"Electric Field, [V/cm]","Speed, [cm/s]","Electrons Velocity of the Drift Model","VelocityModel_Electrons");
+
     delete velocity_plot;
     delete mobility_fit;
+    delete [] efield;
+    delete [] vmodel;
 
     delete speed;
     delete field;
@@ -10,6 +10,7 @@
 // TCT includes
 #include "scanning.h"
 #include "TCTReader.h"
+#include "TCTCatalog.h"
 #include "TCTModule.h"
 #include "modules/ModuleLaserAnalysis.h"
 
@@ -20,38 +21,34 @@
 // External includes
 
 namespace TCT {
+
+// -3 is the time shift, you can shift a signal to start at t=0. FIXME
+static const float time_shift = -3;
+
 /// Analysis manager
 #ifndef USE_GUI
-        bool Scanning::ReadTCT(char* filename, tct_config* config1) {
+        bool Scanning::ReadTCT(char* filename, tct_config* config1, ULong64_t hash, TCTReader* reader) {
 #else
 /// Analysis manager
-        bool Scanning::ReadTCT(char* filename, tct_config* config1, Ui::ConsoleOutput *progress) {
+        bool Scanning::ReadTCT(char* filename, tct_config* config1, Ui::ConsoleOutput *progress, ULong64_t hash, TCTReader* reader) {
 #endif
             /** Opens TCT data file, checks it, creates root file, runs analysis according to the config file.
              *  \param[in] filename Name of the TCT data file
              *  \param[in] config1 Pointer to the TCT::tct_config class
              *  \param[in] progress Pointer to the progress bar
+             *  \param[in] hash Content hash of the data file if already known (see Prefetch), 0 otherwise
+             *  \param[in] reader The file already read and corrected by Prefetch, NULL otherwise; it is deleted here
               */
         config = config1;
 
-        // -3 is the time shift, you can shift a signal to start at t=0. FIXME
-        stct = new TCTReader(filename,-3,2);
-
-        // Function corrects the baseline (DC offset) of all wafeforms
-        // Float_t xc ; time denoting the start of the pulse
-        //              correction factor is calculated from all the bins before xc
-        // it integrates from first bin to bin with t=10, and then shifts by the mean value
-        stct->CorrectBaseLine(config->CorrectBias());
+        // the file is opened and corrected here unless Prefetch did it in the background
+        if(reader) stct = reader;
+        else stct = OpenTCT(filename,ReadSettings(config,time_shift),hash,std::cout);
+        stct->FileName = filename;
 
         // CheckData: check if channels are set in config file 
         if(!CheckData()) {std::cout<<"File "<<filename<<" contains not enough data for selected operations. Skipping."<<std::endl; delete stct; return false;}
 
-        //If detector signal at channel 1 is positive, make in negative
-        stct->CorrectPolarity((config->CH1_Det())-1);
-
-        //If detector signal at channel 2 is positive, make in negative
-        stct->CorrectPolarity((config->CH2_Det())-1);
-
         //create output file
         CreateOutputFile();
 
@@ -84,6 +81,212 @@ namespace TCT {
         return true;
     }
 
+/// Settings of the reading and of the corrections, taken from the configuration
+ReadSettings::ReadSettings(tct_config* config, float time0) :
+    time0(time0), mode(config->ReaderMode()), cache(config->ReaderCache()),
+    base(0), flip(0), need(0), cum(0),
+    method(config->BaselineMethod()), trim(config->BaselineTrim()), tail(config->BaselineTail()),
+    bias(config->CorrectBias()),
+    threads(config->Threads()>1 ? 1 : 0),
+    folder(config->CacheFolder()), name(Scanning::CacheSettings(config,time0)) {
+    /** Several files processed at the same time already use all cores, then Preprocess uses one thread.
+     *  The cache folder is created here, on the thread of the analysis.
+     *  \param[in] config Pointer to the TCT::tct_config class
+     *  \param[in] time0 Time shift of the waveforms
+     */
+    if(config->CH1_Det()) {base |= 1<<(config->CH1_Det()-1); flip |= 1<<(config->CH1_Det()-1);}
+    if(config->CH2_Det()) {base |= 1<<(config->CH2_Det()-1); flip |= 1<<(config->CH2_Det()-1);}
+    if(config->CH_PhDiode()) base |= 1<<(config->CH_PhDiode()-1);
+    need = base;
+    if(config->CH_Trig()) need |= 1<<(config->CH_Trig()-1);
+    if(config->IntegralTables()) cum = base;
+    if(folder != "") gSystem->mkdir(folder.c_str(),kTRUE);
+}
+
+/// Opens the data file, or its cache file, and corrects the waveforms
+TCTReader* Scanning::OpenTCT(char* filename, const ReadSettings &settings, ULong64_t hash, std::ostream &out) {
+    /** Only the TCTReader is used. In ReaderMode 1 and 2 it makes no ROOT objects until a histogram is
+     *  requested, so the function can run on another thread (see Prefetch) with its own out.
+     *  The corrections are not applied if CheckData is going to reject the file.
+     *  \param[in] filename Name of the TCT data file
+     *  \param[in] settings Settings of the reading and of the corrections
+     *  \param[in] hash Content hash of the data file, computed here if 0 and needed
+     *  \param[out] out Stream of the messages
+     *  \return The reader, to be deleted by the caller
+     */
+    TCTReader *stct;
+    Long64_t size,mtime;
+
+    // corrected waveforms of a previous run, "" if the cache is off
+    std::string cachefile = CacheFile(filename,settings,hash);
+    bool cached = cachefile != "" && TCTCatalog::Stat(cachefile.c_str(),size,mtime);
+
+    // ReaderMode 1 maps the file and builds the histograms only when they are requested
+    // ReaderMode 3 reads the waveforms on request and keeps ReaderCache of them in memory
+    // ReaderMode 4 keeps only one voltage slice in memory, for files larger than RAM
+    if(cached) {
+        char cachename[1000];
+        strcpy(cachename,cachefile.c_str());
+        out<<"Corrected waveforms are read from the cache "<<cachefile<<std::endl;
+        stct = new TCTReader(cachename,settings.time0,2,settings.mode,settings.cache,&out);
+        stct->FileName = filename;
+    }
+    else stct = new TCTReader(filename,settings.time0,2,settings.mode,settings.cache,&out);
+
+    for(int k=0;k<4;k++) if((settings.need & (1<<k)) && !stct->WFOnOff[k]) return stct;
+    if(settings.flip == 0) return stct;
+
+    // prefix sums of the detector and photodiode waveforms for the charges of the modules
+    if(settings.cum) {
+        stct->SetIntegrals(settings.cum);
+        if(cached) stct->BuildIntegrals();
+    }
+
+    if(!cached) {
+        // Corrects the baseline (DC offset) of the detector and photodiode waveforms and makes
+        // the detector signals negative, in one pass over the waveforms.
+        // The baseline is estimated from the bins before t=CorrectBias (start of the pulse), see BaselineMethod.
+        stct->SetBaseLine(settings.method,settings.trim,settings.tail);
+        stct->Preprocess(settings.bias,settings.base,settings.flip,settings.threads);
+
+        // keep the corrected waveforms for the next run, the cache file appears only when it is complete
+        if(cachefile != "") {
+            std::string tmp = cachefile + ".tmp";
+            if(stct->WriteBin(tmp.c_str()) && rename(tmp.c_str(),cachefile.c_str()) == 0)
+                out<<"Corrected waveforms are kept in the cache "<<cachefile<<std::endl;
+        }
+    }
+    return stct;
+}
+
+/// Name of the cache file of the corrected waveforms
+std::string Scanning::CacheFile(const char* filename, const ReadSettings &settings, ULong64_t hash) {
+    /** The name is made of the hash of the file content and of all settings the corrections depend on.
+     *  \param[in] filename Name of the TCT data file
+     *  \param[in] settings Settings of the reading and of the corrections
+     *  \param[in] hash Content hash of the data file, computed here if 0
+     *  \return Path of the cache file, empty if the cache is off
+     */
+    if(settings.folder == "") return "";
+    if(hash == 0) hash = FileHash(filename);
+    if(hash == 0) return "";
+    return settings.folder + "/" + CacheName(hash,settings.name);
+}
+
+/// Content hash of the data file
+ULong64_t Scanning::FileHash(const char* filename, bool* hashed) {
+    /** The hash is taken from the catalog of the data folder if the file was not changed since
+     *  it was catalogued, otherwise the whole file is hashed.
+     *  \param[in] filename Name of the TCT data file
+     *  \param[out] hashed Set to true if the file had to be read
+     *  \return Hash of the file, 0 if it can not be read
+     */
+    std::string folder(filename);
+    size_t slash = folder.rfind('/');
+    folder = (slash == std::string::npos) ? "." : folder.substr(0,slash);
+    TCTCatalog catalog(folder.c_str());
+    int entry = catalog.Load() ? catalog.Find(filename) : -1;
+    if(hashed) *hashed = entry < 0;
+    return (entry >= 0) ? catalog.GetEntry(entry).Hash : TCTCatalog::Hash(filename);
+}
+
+/// Correction settings of the cache file name
+std::string Scanning::CacheSettings(tct_config* config, float time0) {
+    /** Every setting the corrections depend on is a part of the name. ReaderMode is not: every Mode
+     *  corrects the baseline and decides the polarity from all waveforms, so the written files are
+     *  the same (checked by test/test_writebin.cc) and a cache file can be used in any Mode.
+     *  \param[in] config Pointer to the TCT::tct_config class
+     *  \param[in] time0 Time shift of the waveforms
+     */
+    char name[300];
+    sprintf(name,"t%g_b%g_c%d%d%d_m%d",time0,config->CorrectBias(),
+            config->CH1_Det(),config->CH2_Det(),config->CH_PhDiode(),config->BaselineMethod());
+    std::string out(name);
+    if(config->BaselineMethod() == 2) {sprintf(name,"_%g",config->BaselineTrim()); out += name;}
+    if(config->BaselineMethod() == 3) {sprintf(name,"_%g",config->BaselineTail()); out += name;}
+    return out;
+}
+
+/// Name of the cache file for the given hash and correction settings (see CacheSettings)
+std::string Scanning::CacheName(ULong64_t hash, const std::string &settings) {
+    char name[20];
+    sprintf(name,"%016llx_",(unsigned long long)hash);
+    return name + settings + ".tct";
+}
+
+/// Starts reading the data file in the background
+void Prefetch::Start(std::string filename, tct_config* config) {
+    /** Only one file is read ahead, so at most two scans (the analysed one and the next one) are
+     *  held at a time. The settings are copied, the thread does not touch the config.
+     *  \param[in] filename Name of the next TCT data file
+     *  \param[in] config Pointer to the TCT::tct_config class
+     */
+    Wait("");
+    file = filename;
+    path.assign(file.begin(),file.end());
+    path.push_back('\0');
+    settings = new ReadSettings(config,time_shift);
+    worker = std::thread(&Prefetch::Run,this);
+}
+
+/// Waits for the background reading to finish
+ULong64_t Prefetch::Wait(std::string filename, TCTReader** next) {
+    /** The reader made in the background is handed over if it belongs to filename, otherwise it is deleted.
+     *  Its messages are printed here, on the thread of the analysis.
+     *  \param[in] filename Name of the data file which is going to be analysed
+     *  \param[out] next The reader of the file, read and corrected (see Scanning::OpenTCT), NULL if none
+     *  \return Content hash of the file if it was read ahead and the cache is on, 0 otherwise
+     */
+    ULong64_t out = 0;
+    if(worker.joinable()) worker.join();
+    if(next) *next = NULL;
+    if(filename == file && file != "") {
+        out = hash;
+        std::cout<<log.str();
+        if(next) {*next = reader; reader = NULL;}
+    }
+    delete reader;
+    delete settings;
+    reader = NULL;
+    settings = NULL;
+    hash = 0;
+    file = "";
+    log.str("");
+    return out;
+}
+
+Prefetch::~Prefetch() {
+    Wait("");
+}
+
+/// Reads the file which ReadTCT is going to open
+void Prefetch::Run() {
+    /** In ReaderMode 1 and 2 the reader is made and the corrections are applied here (see Scanning::OpenTCT),
+     *  in the other Modes the reader makes ROOT objects, which is not thread safe, and the file (or its
+     *  cache file) is only read, so it comes from the page cache of the system.
+     */
+    if(settings->mode == 1 || settings->mode == 2) {
+        reader = Scanning::OpenTCT(&path[0],*settings,0,log);
+        return;
+    }
+
+    std::string open = file;
+    bool hashed = false;
+    Long64_t size,mtime;
+    if(settings->folder != "") {
+        hash = Scanning::FileHash(file.c_str(),&hashed);
+        std::string cachefile = hash ? settings->folder + "/" + Scanning::CacheName(hash,settings->name) : "";
+        if(cachefile != "" && TCTCatalog::Stat(cachefile.c_str(),size,mtime)) {open = cachefile; hashed = false;}
+    }
+    if(hashed) return;
+
+    std::vector<char> buf(1<<22);
+    FILE *in = fopen(open.c_str(),"rb");
+    if(in == NULL) return;
+    while(fread(&buf[0],1,buf.size(),in) == buf.size());
+    fclose(in);
+}
+
 /// Creates output file
 bool Scanning::CreateOutputFile() {
 
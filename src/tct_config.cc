@@ -31,6 +31,7 @@ void tct_config::SetParameters(std::map<std::string, std::string> id_val){
     for( auto i : id_val){
         if(i.first == "OutFolder")	_OutFolder = i.second;
         if(i.first == "DataFolder")	_DataFolder = i.second;
+        if(i.first == "CacheFolder")	_CacheFolder = i.second;
 
         //tct scanning mode parameters
         if(i.first == "CH1_Detector")		_CH1_Det = atoi((i.second).c_str());
@@ -52,6 +53,15 @@ void tct_config::SetParameters(std::map<std::string, std::string> id_val){
         if(i.first == "TCT_Mode")         _TCT_Mode = atoi((i.second).c_str());
         if(i.first == "Voltage_Source")   _VoltSource = atoi((i.second).c_str());
         if(i.first == "CorrectBias")          _CorrectBias = atof((i.second).c_str());
+        if(i.first == "BaselineMethod")       _BaselineMethod = atoi((i.second).c_str());
+        if(i.first == "BaselineTrim")         _BaselineTrim = atof((i.second).c_str());
+        if(i.first == "BaselineTail")         _BaselineTail = atof((i.second).c_str());
+        if(i.first == "IntegralTables")       _IntegralTables = static_cast<bool>(atoi((i.second).c_str()));
+        if(i.first == "FastFit")              _FastFit = static_cast<bool>(atoi((i.second).c_str()));
+        if(i.first == "FitContinuation")      _FitContinuation = static_cast<bool>(atoi((i.second).c_str()));
+        if(i.first == "ReaderMode")           _ReaderMode = atoi((i.second).c_str());
+        if(i.first == "ReaderCache")          _ReaderCache = atoi((i.second).c_str());
+        if(i.first == "Threads")              _Threads = atoi((i.second).c_str());
 
         //modular system
         if(i.first == "Focus_Search_Top")	    	RegisterModule(new ModuleTopFocus(this,"Focus_Search",_Top,"Focus Search"),static_cast<bool>(atoi((i.second).c_str())));
@@ -69,6 +79,8 @@ void tct_config::SetParameters(std::map<std::string, std::string> id_val){
         if(i.first == "Mu0_Electrons")                _mu0_els = atof((i.second).c_str());
         if(i.first == "Mu0_Holes")                    _mu0_holes = atof((i.second).c_str());
         if(i.first == "SaturationVelocity")           _v_sat = atof((i.second).c_str());
+        if(i.first == "DriftModel")                   _DriftModel = atoi((i.second).c_str());
+        if(i.first == "Temperature")                  _Temperature = atof((i.second).c_str());
         if(i.first == "Amplification")                _ampl = atof((i.second).c_str());
         if(i.first == "LightSplitter")                _light_split = atof((i.second).c_str());
         if(i.first == "ResistanceSensor")             _R_sensor = atof((i.second).c_str());
@@ -78,6 +90,7 @@ void tct_config::SetParameters(std::map<std::string, std::string> id_val){
 
 
     }
+    if(_FastFit) std::cout<<"FastFit is experimental, its fits are not yet compared with Minuit under ROOT 5 (test/bench_fitter_root).\n";
     for( auto i : id_val) {
         if(i.first == "EV_Time")                    ((ModuleEdgeField*)GetModule("EdgeVelocityProfile"))->SetEV_Time(atof((i.second).c_str()));
     }
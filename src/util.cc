@@ -10,6 +10,9 @@
 #include <fstream>
 #include <stdexcept>
 #include <map>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
 
 //  includes from TCT classes
 #include "util.h"
@@ -49,4 +52,73 @@ namespace TCT {
 
     return;
   }
+
+  bool NaturalLess(const std::string &a, const std::string &b){
+    size_t i = 0, j = 0;
+    while(i < a.size() && j < b.size()) {
+      if(isdigit(a[i]) && isdigit(b[j])) {
+        // without leading zeros the longer number is larger, numbers of equal length compare as text
+        while(i < a.size() && a[i] == '0') i++;
+        while(j < b.size() && b[j] == '0') j++;
+        size_t ie = i, je = j;
+        while(ie < a.size() && isdigit(a[ie])) ie++;
+        while(je < b.size() && isdigit(b[je])) je++;
+        if(ie-i != je-j) return ie-i < je-j;
+        int c = a.compare(i,ie-i,b,j,je-j);
+        if(c != 0) return c < 0;
+        i = ie; j = je;
+      }
+      else {
+        if(a[i] != b[j]) return a[i] < b[j];
+        i++; j++;
+      }
+    }
+    if(a.size()-i != b.size()-j) return a.size()-i < b.size()-j;
+    return a < b;
+  }
+
+  bool ParseSamples(FILE *infile, std::vector<double> &volt, float &minvolt, float &maxvolt){
+
+    // the file is read into memory at once and the numbers are converted in one pass,
+    // the buffer is kept by each thread for the next file
+    static thread_local std::vector<char> text;
+    long start = ftell(infile);
+    fseek(infile,0,SEEK_END);
+    long size = ftell(infile)-start;
+    fseek(infile,start,SEEK_SET);
+    if(size < 0) size = 0;
+    text.resize(size+1);
+    size = fread(&text[0],1,size,infile);
+    text[size] = '\0';
+    char *p = &text[0], *e = p+size, *end;
+    double in_v = 0;
+
+    // header, the first 30 words
+    for(int k=0; k<30; k++){
+      while(p<e && isspace((unsigned char)*p)) p++;
+      while(p<e && !isspace((unsigned char)*p)) p++;
+    }
+
+    // time and voltage of each sample (the time is not used, the samples are equidistant)
+    volt.reserve(volt.size()+size/20);
+    while(1)
+    {
+      while(p<e && isspace((unsigned char)*p)) p++;
+      if(p>=e) break;
+      strtod(p,&end);
+      if(end!=p) {
+        p = end;
+        while(p<e && isspace((unsigned char)*p)) p++;
+        if(p>=e) break;
+        in_v = strtod(p,&end);
+      }
+      if(end==p) return false;
+      p = end;
+      if(in_v > maxvolt) maxvolt = in_v;
+      if(in_v < minvolt) minvolt = in_v;
+      volt.push_back(in_v);
+    }
+
+    return true;
+  }
 }
@@ -0,0 +1,47 @@
+/**
+ * \file
+ * \brief Synthetic charge profiles for the checks of TCT::Fitter.
+ */
+
+#ifndef __TESTPROFILES_H__
+#define __TESTPROFILES_H__ 1
+
+#include <vector>
+
+#include "TCTFitter.h"
+#include "TestScan.h"
+
+/// A model with the true parameters of the profiles and the start values of the fits
+struct ProfileCase {
+    const char *name;
+    const TCT::FitModel *model;
+    double par[4];
+    double start[4];
+};
+
+/// Edges and strip as fitted by FindEdges and the Top focus search, 200 points with 2 um sampling
+inline std::vector<ProfileCase> ProfileCases()
+{
+    static TCT::ErfcEdgeModel left;
+    static TCT::ErfEdgeModel right;
+    static TCT::StripModel strip;
+    ProfileCase c[3]={
+        {"erfc edge",&left,{150,8,0.5,1},{140,12,0.4,0.9}},
+        {"erf edge",&right,{250,8,0.5,0},{262,12,0.6,0.1}},
+        {"strip",&strip,{120,6,1,150},{112,9,0.8,160}}
+    };
+    return std::vector<ProfileCase>(c,c+3);
+}
+
+/// Points x=0,2,..,398 um of the model with uniform noise of amplitude noise, the profile seed
+inline void MakeProfile(const ProfileCase &c, double noise, unsigned int seed, std::vector<double> &x, std::vector<double> &y)
+{
+    x.resize(200);
+    y.resize(200);
+    for(int i=0;i<200;i++) {
+        x[i]=2.*i;
+        y[i]=c.model->Eval(x[i],c.par,0)+noise*TestNoise(seed);
+    }
+}
+
+#endif
@@ -0,0 +1,46 @@
+/**
+ * \file
+ * \brief Synthetic TCT scans for the tests and benchmarks.
+ */
+
+#ifndef __TESTSCAN_H__
+#define __TESTSCAN_H__ 1
+
+#include <stdio.h>
+#include <vector>
+#include <functional>
+
+/// Writes a type 33 little endian file (Bin=2) with Nx*Ny waveforms of channel 1 at one voltage
+/** The positions are x=i, y=2*j um, the time step is 0.1 ns. sample(wf,i) gives the i-th sample of
+ *  the waveform wf (wf=x+Nx*y, the index used by TCTReader). Returns false if the file can not be written.
+ */
+inline bool WriteScan(const char *file, int Nx, int Ny, int NP, const std::function<float(int,int)> &sample)
+{
+    FILE *out=fopen(file,"wb");
+    if(out==NULL) return false;
+    int i,j,x,y,zero=0;
+    float head[]={33, 2016,5,4,12,0,0, 0, 0,1,(float)Nx, 0,2,(float)Ny, 0,1,1, 1,0,0,0, 1,100, 1,0, 0,0.1f,(float)NP, 295,0};
+    float rec[4]={100,0,1e-6f,0};
+    std::vector<float> wf(NP);
+    fwrite(head,sizeof(float),sizeof(head)/sizeof(float),out);
+    for(i=0;i<3;i++) fwrite(&zero,sizeof(int),1,out);   // User, Sample, Comment
+    fwrite(rec,sizeof(float),4,out);
+    for(j=0,y=0;y<Ny;y++)
+        for(x=0;x<Nx;x++,j++)
+        {
+            float c[4]={(float)x,(float)(2*y),0,0};
+            fwrite(c,sizeof(float),4,out);
+            for(i=0;i<NP;i++) wf[i]=sample(j,i);
+            fwrite(&wf[0],sizeof(float),NP,out);
+        }
+    return fclose(out)==0;
+}
+
+/// Deterministic noise, uniform in [-1,1), the same on every platform
+inline float TestNoise(unsigned int &seed)
+{
+    seed=seed*1103515245u+12345u;
+    return ((seed>>8)&0xFFFF)/32768.f-1.f;
+}
+
+#endif
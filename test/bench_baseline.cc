@@ -0,0 +1,97 @@
+/**
+ * \file
+ * \brief Check and timing of the baseline estimators of TCTReader (see SetBaseLine).
+ * \details Two synthetic scans are corrected in Mode=2 with every estimator. In the first the
+ * baseline is flat with a random offset per waveform and with spikes before the pulse, the median
+ * and the trimmed mean must remove the offset. In the second the baseline drifts linearly, the line
+ * fitted to the bins before the pulse and after its tail must remove the drift. The residual
+ * baseline of every estimator and the time of Preprocess relative to the mean are printed.
+ * Usage: bench_baseline [number of waveforms] [samples per waveform] [repetitions]
+ */
+
+// STD includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <chrono>
+#include <sstream>
+
+// TCT includes
+#include "TCTReader.h"
+#include "TestScan.h"
+
+static const char *Name[4]={"mean","median","trimmed mean","line"};
+
+// pulse at the middle of the waveform, the baseline is estimated up to 5 ns before it and from 10 ns after it
+struct Scan
+{
+    Int_t Num,NP;
+    Bool_t drift;
+    Int_t pulse() const {return NP/2;}
+    Bool_t spike(Int_t i) const {return !drift && i%50==7 && i<pulse()-60;}
+    Bool_t quiet(Int_t i) const {return (i<pulse()-60 || i>=pulse()+110) && !spike(i) && i<NP-1;}
+    Float_t sample(Int_t j, Int_t i) const
+    {
+        unsigned int seed=j*NP+i, s=j;
+        Float_t offset=0.2f*TestNoise(s), slope=drift?2e-4f*TestNoise(s):0;
+        Float_t v=offset+slope*i+0.01f*TestNoise(seed)-exp(-0.5*pow((i-pulse())/3.0,2));
+        if(spike(i)) v+=0.5f;
+        return v;
+    }
+};
+
+// corrects the scan with the estimator method, returns the time of Preprocess in ms and the rms of the residual baseline
+static double Correct(const char *file, const Scan &s, Int_t method, Int_t rep, double &rms)
+{
+    double best=1e30,t,sum,sum2=0;
+    Int_t r,i,j,n;
+    std::ostringstream log;
+    Float_t xc=0.1f*(s.pulse()-50), tail=0.1f*(s.pulse()+100);
+    for(r=0;r<rep;r++)
+    {
+        TCTReader reader((Char_t *)file,0,2,2,4096,&log);
+        reader.SetBaseLine(method,0.1,tail);
+        std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+        reader.Preprocess(xc,1,0,1);
+        t=std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+        if(t<best) best=t;
+        if(r>0) continue;
+        for(sum2=0,j=0;j<s.Num;j++)
+        {
+            Float_t *wf=reader.GetWF(0,j);
+            for(sum=0,n=0,i=0;i<s.NP;i++) if(s.quiet(i)) {sum+=wf[i]; n++;}
+            sum2+=(sum/n)*(sum/n);
+        }
+    }
+    rms=sqrt(sum2/s.Num);
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    Int_t num=(argc>1)?atoi(argv[1]):200000;
+    Int_t np=(argc>2)?atoi(argv[2]):1000;
+    Int_t rep=(argc>3)?atoi(argv[3]):3;
+    Int_t d,m,bad=0;
+    Char_t file[]="bench_baseline_scan.tct";
+    double rms[4],time[4];
+
+    for(d=0;d<2;d++)
+    {
+        Scan s={num,np,d==1};
+        if(!WriteScan(file,num,1,np,[&s](int j,int i) {return s.sample(j,i);})) {printf("Can not write %s\n",file); return 1;}
+        printf("%s baseline, %d waveforms of %d samples, %d bins before the pulse\n",s.drift?"drifting":"flat with spikes",num,np,s.pulse()-50);
+        for(m=0;m<4;m++)
+        {
+            time[m]=Correct(file,s,m,rep,rms[m]);
+            printf("  %-13s %9.2f ms (%.2fx of the mean)   residual baseline rms %.5f\n",Name[m],time[m],time[m]/time[0],rms[m]);
+        }
+        // the noise is 0.01 per sample, a good estimate leaves much less
+        if(!s.drift) for(m=1;m<3;m++) if(rms[m]>0.003) {printf("FAILED: %s does not remove the flat baseline\n",Name[m]); bad++;}
+        if(s.drift && rms[3]>0.003) {printf("FAILED: %s does not remove the drifting baseline\n",Name[3]); bad++;}
+        remove(file);
+    }
+    if(!bad) printf("Baseline estimators passed\n");
+    return bad?1:0;
+}
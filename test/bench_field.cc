@@ -0,0 +1,122 @@
+/**
+ * \file
+ * \brief Check and timing of the field solver of the edge-TCT (TCT::Normalisation).
+ * \details Charge profiles are made from known field profiles with the drift model of the
+ * configuration (DriftModel = 0). The solver must give back the normalisation constant and the
+ * field, and the field must agree with the one of the bisection used before (copied below). A
+ * voltage which can not be reached, or not within the precision, must be reported. The time per
+ * voltage of both is printed.
+ * Usage: bench_field [number of points] [number of voltages]
+ */
+
+// STD includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <chrono>
+
+// TCT includes
+#include "TCTDrift.h"
+#include "TCTField.h"
+
+static const double mu0_els=1350, mu0_holes=480, v_sat=1e7;
+
+/// The bisection of ModuleEdgeField before the table and Brent's method
+struct Bisection {
+    static double Mu(double E, int Type) {
+        if(Type==1) return mu0_holes/(1.+mu0_holes*E/v_sat);
+        if(Type==0) return mu0_els/sqrt(1.+mu0_els*E/v_sat*mu0_els*E/v_sat);
+        else return 0;
+    }
+    static double ff(double E, double Uuu, double a) { return Uuu-a*(Mu(E,1)+Mu(E,0))*E; }
+    static int sgn(double val) { return (0 < val) - (val < 0); }
+    static double BiSectionMethod(double eps, double x1, double x2, double Uuu, double a) {
+        if(ff(x1,Uuu,a)==0) return x1;
+        if(ff(x2,Uuu,a)==0) return x2;
+        double dx = x2-x1;
+        double xi = x1; // not initialised before
+        while(fabs(ff(xi,Uuu,a))>eps) {
+            dx = dx/2;
+            xi = x1+dx;
+            if(sgn(ff(x1,Uuu,a))!=sgn(ff(xi,Uuu,a))) continue;
+            else x1=xi;
+        }
+        return xi;
+    }
+    /// returns the constant of the last field profile
+    static double Solve(double U, int numS, const double *charge, int ix1, int ix2, double Ss, double eps, double *field) {
+        double a=1, used=a;
+        double dx = 0.5*a;
+        double sum = 0;
+        while(fabs(fabs(U)-sum)>eps) {
+            for(int i=0; i<numS; i++) field[i] = BiSectionMethod(eps,-5e3,1e6,charge[i],a);
+            sum=0;
+            for(int i=ix1;i<=ix2;i++) sum+=field[i];
+            sum*=1e-4*Ss;
+            used=a;
+            if(fabs(U)-sum>0) a-=dx;
+            else a+=dx;
+            dx=dx/2;
+        }
+        return used;
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    int numS=(argc>1)?atoi(argv[1]):300;
+    int numVolt=(argc>2)?atoi(argv[2]):10;
+    int ix1=numS/6, ix2=numS*5/6, i,j,bad=0;
+    const double Ss=1, eps=1e-3, a_true=0.7;
+    double d=(ix2-ix1)*Ss;
+    double time[2]={0,0};
+    std::vector<double> E(numS),charge(numS),field(numS),old(numS);
+    TCT::DriftModel drift(TCT::DriftModel::kConfig,mu0_els,mu0_holes,v_sat);
+
+    for(j=0;j<numVolt;j++) {
+        // linear field in the sensor, no field outside, the voltage is its integral; with the
+        // constants tried by the bisection the fields must stay below saturation, or it does not stop
+        double U=10+190.*j/(numVolt>1?numVolt-1:1), sum=0;
+        for(i=0;i<numS;i++) E[i]=(i<ix1 || i>ix2) ? 0 : 1.+0.8*(ix2-i)*Ss/d;
+        for(i=ix1;i<=ix2;i++) sum+=E[i];
+        for(i=0;i<numS;i++) {E[i]*=U/(sum*1e-4*Ss); charge[i]=a_true*drift.ExactVelocity(E[i],0)+a_true*drift.ExactVelocity(E[i],1);}
+
+        double a=1;
+        std::chrono::steady_clock::time_point t0=std::chrono::steady_clock::now();
+        bool ok=TCT::Normalisation(drift,U,numS,&charge[0],ix1,ix2,Ss,a,eps,&field[0]);
+        std::chrono::steady_clock::time_point t1=std::chrono::steady_clock::now();
+        double a_old=Bisection::Solve(U,numS,&charge[0],ix1,ix2,Ss,eps,&old[0]);
+        std::chrono::steady_clock::time_point t2=std::chrono::steady_clock::now();
+        time[0]+=std::chrono::duration<double,std::milli>(t1-t0).count();
+        time[1]+=std::chrono::duration<double,std::milli>(t2-t1).count();
+
+        double v=TCT::FieldProfile(drift,numS,&charge[0],ix1,ix2,Ss,a,&field[0]);
+        double dtrue=0,dold=0,emax=0;
+        for(i=0;i<numS;i++) {
+            if(E[i]>emax) emax=E[i];
+            if(fabs(field[i]-E[i])>dtrue) dtrue=fabs(field[i]-E[i]);
+            if(fabs(field[i]-old[i])>dold) dold=fabs(field[i]-old[i]);
+        }
+        dtrue/=emax; dold/=emax;
+        printf("U = %5.1f V: constant %.7f (bisection %.7f), field off by %.2g of its maximum, from the bisection by %.2g\n",U,a,a_old,dtrue,dold);
+        if(!ok || fabs(v-U)>eps) {printf("FAILED: U = %g V not reached (%g V)\n",U,v); bad++;}
+        // both solvers stop within eps of the voltage, the relative precision of the field is about eps/U
+        if(fabs(a-a_true)>2*eps/U*a_true || dtrue>2*eps/U) {printf("FAILED: U = %g V, wrong field\n",U); bad++;}
+        if(dold>4*eps/U) {printf("FAILED: U = %g V, the field differs from the bisection\n",U); bad++;}
+    }
+    printf("%d points: %.3f ms per voltage, bisection %.3f ms (%.0fx)\n",numS,time[0]/numVolt,time[1]/numVolt,time[0]>0?time[1]/time[0]:0);
+
+    // a precision below the rounding of the voltage is not reached, the constant is still the best one found
+    double U=TCT::FieldProfile(drift,numS,&charge[0],ix1,ix2,Ss,a_true,&field[0])+1e-9, a=1;
+    if(TCT::Normalisation(drift,U,numS,&charge[0],ix1,ix2,Ss,a,0,&field[0])) {printf("FAILED: U = %g V reached with eps = 0\n",U); bad++;}
+    if(fabs(a-a_true)>1e-9*a_true) {printf("FAILED: eps = 0, constant %.12f\n",a); bad++;}
+
+    // no charge: no constant gives a voltage, the solver must stop
+    for(i=0;i<numS;i++) charge[i]=0;
+    a=1;
+    if(TCT::Normalisation(drift,100,numS,&charge[0],ix1,ix2,Ss,a,eps,&field[0])) {printf("FAILED: zero charge reaches 100 V\n"); bad++;}
+
+    if(!bad) printf("Field solver passed\n");
+    return bad?1:0;
+}
@@ -0,0 +1,79 @@
+/**
+ * \file
+ * \brief Comparison of TCT::Fitter (FastFit) with the Minuit fit of ROOT (TGraph::Fit).
+ * \details The synthetic edge and strip profiles of test_fitter are fitted with the TF1 of the same
+ * formula from the same start values, as FindEdges and the Top focus search do without FastFit.
+ * The parameters of both fits must agree within a small fraction of their errors, and so must the
+ * errors (both are scaled with sqrt(chi2/ndf) for a graph without errors). The time per fit of both
+ * is printed.
+ * Usage: bench_fitter_root [number of profiles per model]
+ */
+
+// STD includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <chrono>
+
+// ROOT includes
+#include "TGraph.h"
+#include "TF1.h"
+#include "TFitResultPtr.h"
+#include "TFitResult.h"
+
+// TCT includes
+#include "TCTFitter.h"
+#include "TestProfiles.h"
+
+int main(int argc, char *argv[])
+{
+    int num=(argc>1)?atoi(argv[1]):2000;
+    int i,j,k,bad=0;
+    std::vector<ProfileCase> cases=ProfileCases();
+    std::vector<double> x,y;
+
+    for(k=0;k<(int)cases.size();k++) {
+        const ProfileCase &c=cases[k];
+        TF1 ff("ff",c.model->Formula(),0,400);
+        double dpar[4]={0,0,0,0},derr[4]={0,0,0,0},time[2]={0,0};
+        int failed[2]={0,0},ok=0;
+        for(j=0;j<num;j++) {
+            MakeProfile(c,0.02,1000*k+j,x,y);
+            TGraph gr(200,&x[0],&y[0]);
+            double par[4];
+            for(i=0;i<4;i++) par[i]=c.start[i];
+            ff.SetParameters(c.start);
+            for(i=0;i<4;i++) ff.SetParError(i,0);
+
+            std::chrono::steady_clock::time_point t0=std::chrono::steady_clock::now();
+            TCT::Fitter fitter(*c.model);
+            if(!fitter.Fit(200,&x[0],&y[0],0,400,par)) failed[0]++;
+            std::chrono::steady_clock::time_point t1=std::chrono::steady_clock::now();
+            TFitResultPtr r=gr.Fit(&ff,"NQRS");
+            std::chrono::steady_clock::time_point t2=std::chrono::steady_clock::now();
+            if((Int_t)r!=0) {failed[1]++; continue;}
+            ok++;
+            time[0]+=std::chrono::duration<double,std::micro>(t1-t0).count();
+            time[1]+=std::chrono::duration<double,std::micro>(t2-t1).count();
+
+            for(i=0;i<4;i++) {
+                double e=fitter.GetErrors()[i];
+                if(fabs(par[i]-ff.GetParameter(i))/e>dpar[i]) dpar[i]=fabs(par[i]-ff.GetParameter(i))/e;
+                if(fabs(e-ff.GetParError(i))/e>derr[i]) derr[i]=fabs(e-ff.GetParError(i))/e;
+            }
+        }
+        printf("%-10s TCT::Fitter %7.1f us/fit, Minuit %7.1f us/fit (%.1fx), not converged %d and %d\n",
+               c.name,ok?time[0]/ok:0,ok?time[1]/ok:0,time[0]>0?time[1]/time[0]:0,failed[0],failed[1]);
+        for(i=0;i<4;i++) {
+            printf("    par %d: largest difference %.2g errors, of the errors %.2g\n",i,dpar[i],derr[i]);
+            // Minuit stops at a small but finite distance to the minimum (EDM)
+            if(dpar[i]>0.05) {printf("FAILED: %s parameter %d differs from Minuit\n",c.name,i); bad++;}
+            if(derr[i]>0.05) {printf("FAILED: %s error of parameter %d differs from Minuit\n",c.name,i); bad++;}
+        }
+        if(failed[0]+failed[1]>num/100) {printf("FAILED: %s, too many fits not converged\n",c.name); bad++;}
+    }
+
+    if(!bad) printf("TCT::Fitter agrees with Minuit\n");
+    return bad?1:0;
+}
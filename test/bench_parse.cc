@@ -0,0 +1,150 @@
+/**
+ * \file
+ * \brief Check and timing of the parser of the oscilloscope text files (TCT::ParseSamples).
+ * \details Small files with CRLF line ends, without the last newline, with a word that is not a number
+ * and without samples check the edge cases. The given files must give the samples and the polarity of
+ * the two-pass fscanf parser of acquisition_single::Parse used before (copied below), and the time per
+ * file of both is printed.
+ * Usage: bench_parse [repetitions] [text files]
+ */
+
+// STD includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <string>
+#include <chrono>
+
+// TCT includes
+#include "util.h"
+
+/// acquisition_single::Parse before the single pass, the voltages with the polarity applied
+static bool OldParse(FILE *infile, std::vector<double> &volt, double &polarity) {
+    int ret=0;
+    char dummy[20];
+    double in_v, in_t;
+    float minvolt = 1.;
+    float maxvolt = -1.;
+    for(int k=0; k<30; k++) ret = fscanf(infile,"%19s",dummy);
+    while(1) {
+        ret = fscanf(infile,"%lf",&in_t);
+        ret = fscanf(infile,"%lf",&in_v);
+        if(feof(infile)) break;
+        if(in_v > maxvolt) maxvolt = in_v;
+        if(in_v < minvolt) minvolt = in_v;
+        if(ret<=0) return false;
+    }
+    polarity = (maxvolt > fabs(minvolt)) ? 1. : -1.;
+    rewind(infile);
+    for(int k=0; k<30; k++) ret = fscanf(infile,"%19s",dummy);
+    while(1) {
+        ret = fscanf(infile,"%lf",&in_t);
+        ret = fscanf(infile,"%lf",&in_v);
+        if(feof(infile)) break;
+        if(ret<=0) return false;
+        volt.push_back(polarity*in_v);
+    }
+    return true;
+}
+
+/// TCT::ParseSamples and the polarity as in acquisition_single::Parse
+static bool NewParse(FILE *infile, std::vector<double> &volt, double &polarity) {
+    float minvolt = 1.;
+    float maxvolt = -1.;
+    if(!TCT::ParseSamples(infile,volt,minvolt,maxvolt)) return false;
+    polarity = (maxvolt > fabs(minvolt)) ? 1. : -1.;
+    for(size_t i=0; i<volt.size(); i++) volt[i] *= polarity;
+    return true;
+}
+
+/// Temporary file with the text
+static FILE* TextFile(const std::string &text) {
+    FILE *f = tmpfile();
+    if(f) {
+        fwrite(text.data(),1,text.size(),f);
+        rewind(f);
+    }
+    return f;
+}
+
+int main(int argc, char *argv[])
+{
+    int rep=(argc>1)?atoi(argv[1]):20;
+    int i,r,bad=0;
+    double pol,oldpol;
+    std::vector<double> volt,old;
+
+    // header of 30 words as written by the oscilloscope, the samples next to it are skipped with it
+    std::string header="\"Record Length\"\t5\t\"Points\"\t-1e-9\t0.001\r\n\"Sample Interval\"\t1e-010\ts\t-0.9e-9\t-0.002\r\n"
+                       "\"Trigger Point\"\t1000\t\"Samples\"\t-0.8e-9\t-4e-3\r\n\"Trigger Time\"\t0.0664883\ts\t-0.7e-9\t2.5E-003\r\n"
+                       "\t\t\t-0.6e-9\t-1e-3\r\n\"Horizontal Offset\"\t-1e-9\ts\t-0.5e-9\t0.0003\r\n";
+    const double expect[]={-0.0003,0.0042};
+
+    FILE *f=TextFile(header+"\t\t\t-0.4e-9\t-0.0042\r\n");
+    if(!f || !NewParse(f,volt,pol) || volt.size()!=2 || pol!=-1) {printf("FAILED: CRLF file\n"); bad++;}
+    else for(i=0;i<2;i++) if(volt[i]!=expect[i]) {printf("FAILED: CRLF file, sample %d is %g\n",i,volt[i]); bad++;}
+    if(f) {
+        rewind(f);
+        if(!OldParse(f,old,oldpol) || old!=volt || oldpol!=pol) {printf("FAILED: CRLF file differs from the old parser\n"); bad++;}
+        fclose(f);
+    }
+
+    // the last sample is kept without the newline, the old parser dropped it
+    volt.clear();
+    f=TextFile(header+"\t\t\t-0.4e-9\t-0.0042");
+    if(!f || !NewParse(f,volt,pol) || volt.size()!=2 || volt[1]!=0.0042) {printf("FAILED: file without the last newline\n"); bad++;}
+    if(f) fclose(f);
+
+    // a word that is not a number stops at its sample, a time without voltage ends the file
+    volt.clear();
+    float minvolt=1,maxvolt=-1;
+    f=TextFile(header+"-0.4e-9\t0.01\n-0.3e-9\tV\n-0.2e-9\t0.02\n");
+    if(!f || TCT::ParseSamples(f,volt,minvolt,maxvolt) || volt.size()!=2 || maxvolt!=(float)0.01) {printf("FAILED: word that is not a number\n"); bad++;}
+    if(f) fclose(f);
+    volt.clear();
+    f=TextFile(header+"-0.4e-9\t0.01\n-0.3e-9\n");
+    if(!f || !TCT::ParseSamples(f,volt,minvolt,maxvolt) || volt.size()!=2) {printf("FAILED: time without voltage\n"); bad++;}
+    if(f) fclose(f);
+
+    // no samples, and samples appended to the vector
+    volt.clear();
+    f=TextFile("\"Record Length\"\t0\t\"Points\"\n");
+    if(!f || !TCT::ParseSamples(f,volt,minvolt,maxvolt) || volt.size()!=0) {printf("FAILED: file without samples\n"); bad++;}
+    if(f) fclose(f);
+    volt.assign(3,1.);
+    f=TextFile(header);
+    if(!f || !TCT::ParseSamples(f,volt,minvolt,maxvolt) || volt.size()!=4 || volt[2]!=1. || volt[3]!=0.0003) {printf("FAILED: samples not appended\n"); bad++;}
+    if(f) fclose(f);
+
+    // files of a measurement against the old parser
+    double time[2]={0,0};
+    int nfiles=0;
+    for(int a=2;a<argc;a++) {
+        f=fopen(argv[a],"rb");
+        if(!f) {printf("FAILED: can not open %s\n",argv[a]); bad++; continue;}
+        nfiles++;
+        for(r=0;r<rep;r++) {
+            volt.clear(); old.clear();
+            rewind(f);
+            std::chrono::steady_clock::time_point t0=std::chrono::steady_clock::now();
+            bool ok=NewParse(f,volt,pol);
+            std::chrono::steady_clock::time_point t1=std::chrono::steady_clock::now();
+            rewind(f);
+            bool oldok=OldParse(f,old,oldpol);
+            std::chrono::steady_clock::time_point t2=std::chrono::steady_clock::now();
+            time[0]+=std::chrono::duration<double,std::milli>(t1-t0).count();
+            time[1]+=std::chrono::duration<double,std::milli>(t2-t1).count();
+            if(r) continue;
+            if(!ok || !oldok || old.size()==0) {printf("FAILED: %s not parsed\n",argv[a]); bad++;}
+            else if(volt!=old || pol!=oldpol) {printf("FAILED: %s differs from the old parser\n",argv[a]); bad++;}
+            else printf("%s: %d samples, polarity %+g\n",strrchr(argv[a],'/')?strrchr(argv[a],'/')+1:argv[a],(int)volt.size(),pol);
+        }
+        fclose(f);
+    }
+    if(nfiles && rep>0) printf("%d files: %.3f ms per file, old parser %.3f ms\n",nfiles,time[0]/(nfiles*rep),time[1]/(nfiles*rep));
+
+    if(!bad) printf("Parser checks passed\n");
+    return bad?1:0;
+}
@@ -0,0 +1,77 @@
+/**
+ * \file
+ * \brief Check and timing of the byte swapping of the big endian binary files.
+ * \details TCT::SwapBytes must give the same bytes as the original loop (TCT::SwapBytesScalar)
+ * for every length and alignment of the block. The times of both are printed for a large buffer.
+ * Usage: bench_swap [number of floats] [repetitions]
+ */
+
+// STD includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+
+// TCT includes
+#include "TCTSwap.h"
+
+typedef void (*SwapFunction)(float *, int);
+
+// time of one swap of the buffer in ms, the best of rep repetitions
+static double Time(SwapFunction f, std::vector<float> &buf, int rep)
+{
+    double best=1e30, t;
+    for(int r=0;r<rep;r++)
+    {
+        std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+        f(&buf[0],buf.size());
+        t=std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+        if(t<best) best=t;
+    }
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    int n=(argc>1)?atoi(argv[1]):(16<<20);
+    int rep=(argc>2)?atoi(argv[2]):10;
+    int len,ofs,i,bad=0;
+    unsigned int seed=12345;
+
+    if(n<1) n=1;
+    if(rep<1) rep=1;
+
+    // random bytes, so that every byte position is checked
+    std::vector<float> src(n+16), a, b;
+    unsigned char *c=(unsigned char *)&src[0];
+    for(i=0;i<(int)(src.size()*sizeof(float));i++) {seed=seed*1103515245+12345; c[i]=seed>>16;}
+
+    // all tails of the vector blocks and all alignments of the first float
+    for(len=0;len<=67;len++)
+        for(ofs=0;ofs<4;ofs++)
+        {
+            a.assign(src.begin(),src.begin()+len+8);
+            b=a;
+            TCT::SwapBytes(&a[ofs],len);
+            TCT::SwapBytesScalar(&b[ofs],len);
+            if(memcmp(&a[0],&b[0],a.size()*sizeof(float))) {printf("Mismatch at length %d, offset %d\n",len,ofs); bad++;}
+        }
+
+    // large buffer, swapped twice gives back the input
+    a.assign(src.begin(),src.begin()+n);
+    b=a;
+    TCT::SwapBytes(&a[0],n);
+    TCT::SwapBytesScalar(&b[0],n);
+    if(memcmp(&a[0],&b[0],n*sizeof(float))) {printf("Mismatch of the %d floats\n",n); bad++;}
+    TCT::SwapBytes(&a[0],n);
+    if(memcmp(&a[0],&src[0],n*sizeof(float))) {printf("Swapping twice does not restore the %d floats\n",n); bad++;}
+
+    double ts=Time(TCT::SwapBytesScalar,b,rep);
+    double tv=Time(TCT::SwapBytes,a,rep);
+    printf("Swapping %d floats (%.1f MB), best of %d: scalar %.3f ms, SwapBytes %.3f ms, speedup %.2f\n",
+           n,n*sizeof(float)/1048576.,rep,ts,tv,tv>0?ts/tv:0);
+
+    if(bad) printf("FAILED: %d mismatches\n",bad); else printf("SwapBytes matches the scalar swap\n");
+    return bad?1:0;
+}
@@ -0,0 +1,101 @@
+/**
+ * \file
+ * \brief Checks and timing of TCT::DriftModel.
+ * \details For every model and carrier the tabulated velocity and mobility must agree with the
+ * exact formulas (in brackets below 1 kV/cm), be odd and even in the field, and be monotone.
+ * Field() must invert the sum of the velocities. The configuration model must give the formulas
+ * used before the tables, and the Jacoboni parameters at 300 K the Canali ones. The time per
+ * evaluation of the tables is compared with the exact formulas.
+ * Usage: test_drift [number of fields]
+ */
+
+// STD includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <chrono>
+
+// TCT includes
+#include "TCTDrift.h"
+
+using TCT::DriftModel;
+
+int main(int argc, char *argv[])
+{
+    int num=(argc>1)?atoi(argv[1]):100000;
+    int i,k,c,bad=0;
+    const double mu0_els=1400,mu0_holes=450,v_sat=1e7;
+    if(num<10) num=10;
+
+    // fields from 10 V/cm to the end of the tables, logarithmically spaced
+    std::vector<double> E(num),v(num),exact(num);
+    DriftModel reference(DriftModel::kConfig,mu0_els,mu0_holes,v_sat);
+    for(i=0;i<num;i++) E[i]=10*pow(reference.GetEmax()/10,(double)i/(num-1));
+
+    for(k=DriftModel::kConfig;k<=DriftModel::kJacoboni;k++) {
+        DriftModel drift(k,mu0_els,mu0_holes,v_sat,300);
+        for(c=0;c<2;c++) {
+            const char *carrier=(c==DriftModel::kElectron)?"electrons":"holes";
+            double dv[2]={0,0},dmu[2]={0,0},dE=0;
+            int order=0,sym=0;
+            for(i=0;i<num;i++) {
+                double ve=drift.ExactVelocity(E[i],c),me=drift.ExactMobility(E[i],c);
+                double vt=drift.Velocity(E[i],c),mt=drift.Mobility(E[i],c);
+                int low=(E[i]<1000)?1:0;
+                if(fabs(vt-ve)>dv[low]*ve) dv[low]=fabs(vt-ve)/ve;
+                if(fabs(mt-me)>dmu[low]*me) dmu[low]=fabs(mt-me)/me;
+                if(drift.Velocity(-E[i],c)!=-vt || drift.Mobility(-E[i],c)!=mt) sym++;
+                if(i && (vt<drift.Velocity(E[i-1],c) || mt>drift.Mobility(E[i-1],c))) order++;
+                if(!c) {
+                    double u=drift.VelocitySum(E[i]);
+                    double back=drift.Field(u);
+                    if(fabs(back-E[i])>dE*E[i]) dE=fabs(back-E[i])/E[i];
+                    if(drift.Field(-u)!=-back) sym++;
+                }
+            }
+
+            // timing of the batch evaluation against the exact formula
+            std::chrono::steady_clock::time_point t0=std::chrono::steady_clock::now();
+            drift.Velocity(num,&E[0],c,&v[0]);
+            std::chrono::steady_clock::time_point t1=std::chrono::steady_clock::now();
+            for(i=0;i<num;i++) exact[i]=drift.ExactVelocity(E[i],c);
+            std::chrono::steady_clock::time_point t2=std::chrono::steady_clock::now();
+            double time[2]={std::chrono::duration<double,std::nano>(t1-t0).count()/num,
+                            std::chrono::duration<double,std::nano>(t2-t1).count()/num};
+            for(i=0;i<num;i++) if(v[i]!=drift.Velocity(E[i],c)) {printf("FAILED: %s %s batch velocity differs\n",DriftModel::ModelName(k),carrier); bad++; break;}
+
+            printf("%-9s %-9s mu0 %7.1f vsat %.4g beta %.3f: velocity %.2g (%.2g), mobility %.2g (%.2g) relative, table %.1f ns, exact %.1f ns\n",
+                   DriftModel::ModelName(k),carrier,drift.Mu0(c),drift.Vsat(c),drift.Beta(c),dv[0],dv[1],dmu[0],dmu[1],time[0],time[1]);
+            if(!c) printf("%-9s field of the velocity sum %.2g relative\n",DriftModel::ModelName(k),dE);
+
+            // for beta other than 1 or 2 the curvature diverges at E=0 and the first interval of the tables is less precise
+            if(dv[0]>1e-8 || dmu[0]>1e-8 || dv[1]>1e-3 || dmu[1]>1e-3) {printf("FAILED: %s %s tables differ from the formulas\n",DriftModel::ModelName(k),carrier); bad++;}
+            if(dE>1e-8) {printf("FAILED: %s field does not invert the velocity sum\n",DriftModel::ModelName(k)); bad++;}
+            if(sym) {printf("FAILED: %s %s, %d fields break the symmetry\n",DriftModel::ModelName(k),carrier,sym); bad++;}
+            if(order) {printf("FAILED: %s %s, %d fields not monotone\n",DriftModel::ModelName(k),carrier,order); bad++;}
+        }
+    }
+
+    // formulas of the configuration model before the tables
+    double worst=0;
+    for(i=0;i<num;i+=num/10) {
+        double xe=mu0_els*E[i]/v_sat,xh=mu0_holes*E[i]/v_sat;
+        double ve=mu0_els*E[i]/sqrt(1+xe*xe),vh=mu0_holes*E[i]/(1+xh);
+        double d=fabs(reference.ExactVelocity(E[i],DriftModel::kElectron)-ve)/ve;
+        if(d>worst) worst=d;
+        d=fabs(reference.ExactVelocity(E[i],DriftModel::kHole)-vh)/vh;
+        if(d>worst) worst=d;
+    }
+    if(worst>1e-14) {printf("FAILED: configuration model differs from the formulas by %g\n",worst); bad++;}
+
+    // Jacoboni et al. at 300 K reproduce the saturation velocities and betas of Canali et al.
+    DriftModel canali(DriftModel::kCanali,mu0_els,mu0_holes,v_sat,300),jacoboni(DriftModel::kJacoboni,mu0_els,mu0_holes,v_sat,300);
+    for(c=0;c<2;c++)
+        if(fabs(jacoboni.Vsat(c)/canali.Vsat(c)-1)>0.005 || fabs(jacoboni.Beta(c)/canali.Beta(c)-1)>0.005) {
+            printf("FAILED: Jacoboni and Canali parameters differ at 300 K for carrier %d\n",c); bad++;
+        }
+
+    if(!bad) printf("Drift model checks passed\n");
+    return bad?1:0;
+}
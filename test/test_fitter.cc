@@ -0,0 +1,118 @@
+/**
+ * \file
+ * \brief Checks and timing of TCT::Fitter on synthetic edge and strip profiles.
+ * \details For every model the analytic derivatives must agree with central differences, the
+ * fits of noisy profiles must recover the true parameters, and the parameter errors must describe
+ * the spread of the fitted values (rms of the pulls close to 1). The time per fit is compared with
+ * the same solver using central differences instead of the analytic derivatives.
+ * Usage: test_fitter [number of profiles per model]
+ */
+
+// STD includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <chrono>
+
+// TCT includes
+#include "TCTFitter.h"
+#include "TestProfiles.h"
+
+/// The model with numerical derivatives, as a generic formula would be fitted
+class NumericModel : public TCT::FitModel {
+    public :
+        NumericModel(const TCT::FitModel &model) : fModel(model) {}
+        int NPar() const { return fModel.NPar(); }
+        double Eval(double x, const double *par, double *grad) const {
+            if(grad) {
+                double p[TCT::Fitter::MaxPar], h;
+                for(int i=0;i<NPar();i++) p[i] = par[i];
+                for(int i=0;i<NPar();i++) {
+                    h = 1e-6*(fabs(par[i])>1 ? fabs(par[i]) : 1);
+                    p[i] = par[i]+h;
+                    grad[i] = fModel.Eval(x,p,0);
+                    p[i] = par[i]-h;
+                    grad[i] = (grad[i]-fModel.Eval(x,p,0))/(2*h);
+                    p[i] = par[i];
+                }
+            }
+            return fModel.Eval(x,par,0);
+        }
+        const char* Formula() const { return fModel.Formula(); }
+    private :
+        const TCT::FitModel &fModel;
+};
+
+int main(int argc, char *argv[])
+{
+    int num=(argc>1)?atoi(argv[1]):500;
+    int i,j,k,bad=0;
+    const double noise=0.02;
+    std::vector<ProfileCase> cases=ProfileCases();
+    std::vector<double> x,y;
+
+    for(k=0;k<(int)cases.size();k++) {
+        const ProfileCase &c=cases[k];
+        NumericModel numeric(*c.model);
+        double grad[4],ngrad[4],worst=0;
+
+        // derivatives
+        for(i=0;i<200;i++) {
+            double xx=2.*i;
+            c.model->Eval(xx,c.start,grad);
+            numeric.Eval(xx,c.start,ngrad);
+            for(j=0;j<4;j++) if(fabs(grad[j]-ngrad[j])>worst) worst=fabs(grad[j]-ngrad[j]);
+        }
+        if(worst>1e-6) {printf("FAILED: %s derivatives differ by %g\n",c.name,worst); bad++;}
+
+        // fits
+        double pull[4]={0,0,0,0},dev[4]={0,0,0,0},time[2]={0,0};
+        int failed=0;
+        for(j=0;j<num;j++) {
+            MakeProfile(c,noise,1000*k+j,x,y);
+            double par[4],npar[4];
+            for(i=0;i<4;i++) par[i]=npar[i]=c.start[i];
+            TCT::Fitter fitter(*c.model), nfitter(numeric);
+            std::chrono::steady_clock::time_point t0=std::chrono::steady_clock::now();
+            if(!fitter.Fit(200,&x[0],&y[0],0,400,par)) failed++;
+            std::chrono::steady_clock::time_point t1=std::chrono::steady_clock::now();
+            nfitter.Fit(200,&x[0],&y[0],0,400,npar);
+            std::chrono::steady_clock::time_point t2=std::chrono::steady_clock::now();
+            time[0]+=std::chrono::duration<double,std::micro>(t1-t0).count();
+            time[1]+=std::chrono::duration<double,std::micro>(t2-t1).count();
+            for(i=0;i<4;i++) {
+                double p=(par[i]-c.par[i])/fitter.GetErrors()[i];
+                pull[i]+=p*p;
+                if(fabs(par[i]-npar[i])/fitter.GetErrors()[i]>dev[i]) dev[i]=fabs(par[i]-npar[i])/fitter.GetErrors()[i];
+            }
+        }
+        printf("%-10s %7.1f us/fit, numerical derivatives %7.1f us/fit, %d not converged\n",c.name,time[0]/num,time[1]/num,failed);
+        for(i=0;i<4;i++) {
+            pull[i]=sqrt(pull[i]/num);
+            printf("    par %d: pull rms %.3f, difference to numerical derivatives %.2g errors\n",i,pull[i],dev[i]);
+            // the errors describe the spread of the fits, also for a few hundred profiles
+            if(pull[i]<0.8 || pull[i]>1.25) {printf("FAILED: %s parameter %d pull rms %.3f\n",c.name,i,pull[i]); bad++;}
+            if(dev[i]>1e-3) {printf("FAILED: %s parameter %d depends on the derivatives\n",c.name,i); bad++;}
+        }
+        if(failed>num/100) {printf("FAILED: %s, %d fits not converged\n",c.name,failed); bad++;}
+    }
+
+    // the fit range: points outside do not count
+    {
+        const ProfileCase &c=cases[0];
+        MakeProfile(c,0,1,x,y);
+        for(i=150;i<200;i++) y[i]=100;
+        double par[4];
+        for(i=0;i<4;i++) par[i]=c.start[i];
+        TCT::Fitter fitter(*c.model);
+        fitter.Fit(200,&x[0],&y[0],0,250,par);
+        if(fabs(par[0]-c.par[0])>1e-6 || fitter.GetNumberFitPoints()!=126 || fitter.GetNDF()!=122) {
+            printf("FAILED: fit range, edge at %g, %d points\n",par[0],fitter.GetNumberFitPoints());
+            bad++;
+        }
+    }
+
+    if(!bad) printf("Fitter checks passed\n");
+    return bad?1:0;
+}
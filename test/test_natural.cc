@@ -0,0 +1,79 @@
+/**
+ * \file
+ * \brief Checks and timing of TCT::NaturalLess, the order of the acquisition files.
+ * \details Names must sort with their numbers compared as numbers, also with leading zeros and numbers
+ * longer than any integer type, and the order must be strict weak (irreflexive, asymmetric and
+ * transitive), as std::sort needs it. Sorting a directory of numbered files is timed against the
+ * plain comparison of the strings.
+ * Usage: test_natural [number of files]
+ */
+
+// STD includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+// TCT includes
+#include "util.h"
+
+int main(int argc, char *argv[])
+{
+    int num=(argc>1)?atoi(argv[1]):100000;
+    size_t i,j,k;
+    int bad=0;
+
+    // expected order, equal numbers are ordered by the plain comparison of the names
+    const char *names[]={"", "0", "00", "01", "1", "2", "10", "acq", "acq.txt", "acq_0.txt", "acq_01.txt", "acq_1.txt",
+                         "acq_1.txt.swp", "acq_1a.txt", "acq_1b.txt", "acq_2.txt", "acq_9.txt", "acq_010.txt", "acq_10.txt",
+                         "acq_11.txt", "acq_99.txt", "acq_100.txt", "acq_18446744073709551615.txt",
+                         "acq_18446744073709551616.txt", "acq_100000000000000000000000.txt", "acq_a.txt", "scan_2_1.txt",
+                         "scan_2_10.txt", "scan_10_1.txt"};
+    std::vector<std::string> order(names,names+sizeof(names)/sizeof(names[0]));
+
+    for(i=0;i<order.size();i++)
+        for(j=0;j<order.size();j++) {
+            bool less=TCT::NaturalLess(order[i],order[j]);
+            if(less!=(i<j)) {printf("FAILED: \"%s\" < \"%s\" is %d\n",order[i].c_str(),order[j].c_str(),less); bad++;}
+        }
+
+    // strict weak order on all triples, names with digits equal as numbers included
+    std::vector<std::string> set(order);
+    set.push_back("acq_0001.txt"); set.push_back("acq_001.txt"); set.push_back("ACQ_1.txt"); set.push_back("acq_1");
+    int broken=0;
+    for(i=0;i<set.size();i++) {
+        if(TCT::NaturalLess(set[i],set[i])) broken++;
+        for(j=0;j<set.size();j++) {
+            if(TCT::NaturalLess(set[i],set[j]) && TCT::NaturalLess(set[j],set[i])) broken++;
+            for(k=0;k<set.size();k++)
+                if(TCT::NaturalLess(set[i],set[j]) && TCT::NaturalLess(set[j],set[k]) && !TCT::NaturalLess(set[i],set[k])) broken++;
+        }
+    }
+    if(broken) {printf("FAILED: not a strict weak order, %d cases\n",broken); bad++;}
+
+    // shuffled directory listing
+    std::vector<std::string> files(num),sorted;
+    char name[64];
+    for(int n=0;n<num;n++) {
+        snprintf(name,sizeof(name),"acq_%d.txt",n);
+        files[n]=name;
+    }
+    sorted=files;
+    srand(1);
+    for(int n=num-1;n>0;n--) std::swap(files[n],files[rand()%(n+1)]);
+    std::vector<std::string> plain(files);
+
+    std::chrono::steady_clock::time_point t0=std::chrono::steady_clock::now();
+    std::sort(files.begin(),files.end(),TCT::NaturalLess);
+    std::chrono::steady_clock::time_point t1=std::chrono::steady_clock::now();
+    std::sort(plain.begin(),plain.end());
+    std::chrono::steady_clock::time_point t2=std::chrono::steady_clock::now();
+    if(files!=sorted) {printf("FAILED: sorted listing out of order\n"); bad++;}
+    printf("%d files sorted in %.2f ms, plain string order %.2f ms\n",num,
+           std::chrono::duration<double,std::milli>(t1-t0).count(),std::chrono::duration<double,std::milli>(t2-t1).count());
+
+    if(!bad) printf("Natural order checks passed\n");
+    return bad?1:0;
+}
@@ -0,0 +1,78 @@
+/**
+ * \file
+ * \brief Round trip of the corrected waveforms through TCTReader::WriteBin.
+ * \details A synthetic scan is corrected in every Mode and written with WriteBin. All Modes must
+ * write the same file (the cache files do not depend on ReaderMode), and the file read back in
+ * Mode=0 must give the same waveforms, coordinates and voltages as the reader which wrote it.
+ * Every third waveform has the opposite sign, the scan is large enough that a vote on every
+ * Num/1000-th waveform would flip the other way.
+ */
+
+// STD includes
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iterator>
+
+// TCT includes
+#include "TCTReader.h"
+#include "TestScan.h"
+
+static const Int_t Nx=100, Ny=30, NP=100;
+
+static std::string Content(const char *file)
+{
+    std::ifstream in(file,std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in),std::istreambuf_iterator<char>());
+}
+
+int main()
+{
+    Int_t mode,i,j,bad=0;
+    Char_t scan[]="test_writebin_scan.tct", name[100];
+    WriteScan(scan,Nx,Ny,NP,[](int j,int i) {return 0.3f+0.01f*sin(0.7*i+j)+((j%3==0)?1:-1)*exp(-0.5*pow((i-NP/2)/3.0,2));});
+
+    // the same corrections in every Mode give the same file
+    std::string ref;
+    for(mode=0;mode<5;mode++)
+    {
+        TCTReader r(scan,0,2,mode,64);
+        r.SetBaseLine(0);
+        r.Preprocess(2,1,1,2);
+        sprintf(name,"test_writebin_m%d.tct",mode);
+        if(!r.WriteBin(name)) {printf("WriteBin failed in Mode=%d\n",mode); bad++; continue;}
+        if(mode==0) ref=Content(name);
+        else if(Content(name)!=ref) {printf("Mode=%d writes a different file than Mode=0\n",mode); bad++;}
+    }
+
+    // the written file read back in Mode=0 gives the corrected waveforms
+    TCTReader w(scan,0,2,2);
+    w.SetBaseLine(0);
+    w.Preprocess(2,1,1,2);
+    w.WriteBin("test_writebin_m2.tct");
+    TCTReader b((Char_t *)"test_writebin_m2.tct",0,2,0);
+    if(b.type!=33 || b.numxyz!=w.numxyz || b.NP!=w.NP || b.NU1!=w.NU1 || b.NU2!=w.NU2 || b.WFOnOff[0]!=1)
+    {
+        printf("Header differs: type %d, %d waveforms of %d samples\n",b.type,b.numxyz,b.NP);
+        return 1;
+    }
+    if(b.U1[0]!=w.U1[0] || b.I1[0]!=w.I1[0]) {printf("Voltages differ\n"); bad++;}
+    for(j=0;j<w.numxyz;j++)
+    {
+        if(b.xyz[0][j]!=w.xyz[0][j] || b.xyz[1][j]!=w.xyz[1][j] || b.xyz[2][j]!=w.xyz[2][j]) {printf("Coordinates of waveform %d differ\n",j); bad++;}
+        if(memcmp(b.GetWF(0,j),w.GetWF(0,j),NP*sizeof(Float_t))) {printf("Samples of waveform %d differ\n",j); bad++;}
+        if(bad>10) break;
+    }
+    // the majority of the waveforms is negative, the polarity correction makes them positive
+    Float_t *wf=b.GetWF(0,1);
+    for(i=0;i<NP && wf[i]<=wf[NP/2];i++);
+    if(wf[NP/2]<0.5 || i<NP) {printf("Waveform 1 is not corrected (%g at the peak)\n",wf[NP/2]); bad++;}
+
+    for(mode=0;mode<5;mode++) {sprintf(name,"test_writebin_m%d.tct",mode); remove(name);}
+    remove(scan);
+    if(bad) printf("FAILED: %d differences\n",bad); else printf("WriteBin round trip passed\n");
+    return bad?1:0;
+}